@@ -1,31 +1,30 @@
 #include"APU.h"
 
-APU::APU(std::shared_ptr<Scheduler> scheduler)
+APU::APU(Scheduler& scheduler) : m_scheduler(scheduler), m_outputSampleRate(std::clamp(Config::GBA.audioSampleRate, 8000, 192000)), m_resampler(sampleRate, m_outputSampleRate)
 {
 	for (int i = 0; i < 2; i++)
 		m_channels[i].empty();
 
-	m_scheduler = scheduler;
-	m_scheduler->addEvent(Event::AudioSample, &APU::sampleEventCallback, (void*)this, cyclesPerSample);
-	m_scheduler->addEvent(Event::FrameSequencer, &APU::frameSequencerCallback, (void*)this, 32768);
-
-	SDL_Init(SDL_INIT_AUDIO);
-	SDL_AudioSpec desiredSpec = {}, obtainedSpec = {};
-	desiredSpec.freq = sampleRate;
-	desiredSpec.format = AUDIO_F32;	
-	desiredSpec.channels = 2;		
-	desiredSpec.silence = 0;
-	desiredSpec.samples = sampleBufferSize;	
-	m_audioDevice = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &obtainedSpec, 0);
-	SDL_PauseAudioDevice(m_audioDevice, 0);
+	AudioSinkType sinkType = Config::GBA.audioSink;
+	if (!AudioSink::validateOutputPath(sinkType, Config::GBA.audioOutputPath))
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Warn, "Falling back to the audio device");
+		sinkType = AudioSinkType::Device;
+	}
+	m_sink = AudioSink::create(sinkType, Config::GBA.audioOutputPath, m_outputSampleRate);
+	m_resampledBlock.resize(m_resampler.getMaxOutputFrames(sampleBlockSize) * 2);
+	if (m_sink->wantsSamples())		//no point mixing if nothing wants the output
+		scheduleBlockEvent();
+	m_scheduler.addEvent(Event::FrameSequencer, &APU::frameSequencerCallback, (void*)this, 32768);
 
 	m_noiseChannel.LFSR = 0xFFFF;
 	SOUNDBIAS = (0x100) << 1;			//default bias level supposedly 0x100?
+	updateMixerState();
 }
 
 APU::~APU()
 {
-	SDL_Quit();
+
 }
 
 void APU::registerDMACallback(FIFOcallbackFn dmaCallback, void* context)
@@ -81,6 +80,7 @@ uint8_t APU::readIO(uint32_t address)
 
 	case 0x04000090: case 0x04000091: case 0x04000092: case 0x04000093: case 0x04000094: case 0x04000095: case 0x04000096: case 0x04000097:
 	case 0x04000098: case 0x04000099: case 0x0400009A: case 0x0400009B: case 0x0400009C: case 0x0400009D: case 0x0400009E: case 0x0400009F:
+		catchUp();		//playback can flip the bank
 		return m_waveChannel.waveRam[!m_waveChannel.currentBankNumber][address - 0x04000090];
 	}
 	return 0;
@@ -88,6 +88,7 @@ uint8_t APU::readIO(uint32_t address)
 
 void APU::writeIO(uint32_t address, uint8_t value)
 {
+	catchUp();		//everything up to now gets mixed with the old register values
 	switch (address)
 	{
 	case 0x04000060:
@@ -187,16 +188,24 @@ void APU::writeIO(uint32_t address, uint8_t value)
 			triggerNoise();
 		break;
 	case 0x04000080:
+		mixBlock(sampleIndex);		//frames so far were rendered with the old routing/volume
 		SOUNDCNT_L &= 0xFF00; SOUNDCNT_L |= value;
+		updateMixerState();
 		break;
 	case 0x04000081:
+		mixBlock(sampleIndex);
 		SOUNDCNT_L &= 0xFF; SOUNDCNT_L |= (value << 8);
+		updateMixerState();
 		break;
 	case 0x04000082:
+		mixBlock(sampleIndex);
 		SOUNDCNT_H &= 0xFF00; SOUNDCNT_H |= value;
+		updateMixerState();
 		break;
 	case 0x04000083:
+		mixBlock(sampleIndex);
 		SOUNDCNT_H &= 0xFF; SOUNDCNT_H |= (value << 8);
+		updateMixerState();
 		if ((SOUNDCNT_H >> 11) & 0b1)
 		{
 			//clear bit 11 (reset channel A)
@@ -235,47 +244,180 @@ void APU::writeIO(uint32_t address, uint8_t value)
 	}
 }
 
-void APU::onSampleEvent()
+void APU::onBlockEvent()
 {
-	updateSquare1();
-	updateSquare2();
-	updateWave();
-	updateNoise();
-
-	int16_t chanASample = m_channels[0].currentSample << (1+((SOUNDCNT_H  >> 2) & 0b1));		//applies sound a/b volume. 100% = left shift by 1 (*2), 50% = no change
-	int16_t chanBSample = m_channels[1].currentSample << (1+((SOUNDCNT_H >> 3) & 0b1));
+	catchUp();
+	scheduleBlockEvent();
+}
 
-	int psgVolumeShift = (2 - (SOUNDCNT_H & 0b11));	//shift applied to all psg channels
+void APU::scheduleBlockEvent()
+{
+	//when the last sample of the current block ends
+	uint64_t blockEnd = m_nextSampleTimestamp + ((sampleBlockSize - sampleIndex - 1) * cyclesPerSample);
+	m_scheduler.addEvent(Event::AudioSample, &APU::blockEventCallback, (void*)this, blockEnd);
+}
 
-	int16_t square1Sample = m_square1.output >> psgVolumeShift;
-	int16_t square2Sample = m_square2.output >> psgVolumeShift;
-	int16_t waveSample = m_waveChannel.output >> psgVolumeShift;
-	int16_t noiseSample = m_noiseChannel.output >> psgVolumeShift;
+void APU::catchUp()
+{
+	uint64_t curTime = m_scheduler.getCurrentTimestamp();
+	if (m_sink->wantsSamples())
+	{
+		while (m_nextSampleTimestamp <= curTime)
+		{
+			renderSample(m_nextSampleTimestamp);
+			m_nextSampleTimestamp += cyclesPerSample;
+		}
+	}
 
-	//both of these are messy - but it extracts L/R enable bits to see if each channel is enabled for each output (L/R)
-	int16_t leftSample = (((SOUNDCNT_H >> 9) & 0b1) * chanASample) + (((SOUNDCNT_H >> 13) & 0b1) * chanBSample) + (((SOUNDCNT_L >> 12) & 0b1) * square1Sample)
-		+ (((SOUNDCNT_L >> 13) & 0b1) * square2Sample) + (((SOUNDCNT_L >> 14) & 0b1) * waveSample) + (((SOUNDCNT_L >> 15) & 0b1) * noiseSample);
+	//bring the psg channels right up to now as well, so whatever's about to change only affects output from here on.
+	//this happens even with nothing listening - wave bank flips etc. are visible to the game
+	updateSquare1(curTime);
+	updateSquare2(curTime);
+	updateWave(curTime);
+	updateNoise(curTime);
+	if (!m_sink->wantsSamples())		//nothing will ever collect these
+	{
+		m_square1.outputSum = 0; m_square2.outputSum = 0; m_waveChannel.outputSum = 0; m_noiseChannel.outputSum = 0;
+	}
+}
 
-	int16_t rightSample = (((SOUNDCNT_H >> 8) & 0b1) * chanASample) + (((SOUNDCNT_H >> 12) & 0b1) * chanBSample) + (((SOUNDCNT_L >> 8) & 0b1) * square1Sample)
-		+ (((SOUNDCNT_L >> 9) & 0b1) * square2Sample) + (((SOUNDCNT_L >> 10) & 0b1) * waveSample) + (((SOUNDCNT_L >> 11) & 0b1) * noiseSample);
-	m_sampleBuffer[sampleIndex << 1] = clipSample(leftSample);
-	m_sampleBuffer[(sampleIndex << 1) | 1] = clipSample(rightSample);
+void APU::renderSample(uint64_t timestamp)
+{
+	updateSquare1(timestamp);
+	updateSquare2(timestamp);
+	updateWave(timestamp);
+	updateNoise(timestamp);
+
+	//psg channels are averaged over the sample period from their exact step times, rather than point sampled - so high
+	//frequency square/noise don't alias nearly as badly
+	m_channelBlock[FIFOA][sampleIndex] = m_channels[0].currentSample;
+	m_channelBlock[FIFOB][sampleIndex] = m_channels[1].currentSample;
+	m_channelBlock[Square1][sampleIndex] = m_square1.outputSum / cyclesPerSample;
+	m_channelBlock[Square2][sampleIndex] = m_square2.outputSum / cyclesPerSample;
+	m_channelBlock[Wave][sampleIndex] = m_waveChannel.outputSum / cyclesPerSample;
+	m_channelBlock[Noise][sampleIndex] = m_noiseChannel.outputSum / cyclesPerSample;
+	m_square1.outputSum = 0; m_square2.outputSum = 0; m_waveChannel.outputSum = 0; m_noiseChannel.outputSum = 0;
 
 	sampleIndex++;
-	if (sampleIndex == sampleBufferSize)
+	if (sampleIndex == sampleBlockSize)
 	{
+		mixBlock(sampleBlockSize);
 		sampleIndex = 0;
-		//memcpy((void*)m_finalSamples, (void*)m_sampleBuffer, sampleBufferSize * 4);
-		float m_finalSamples[sampleBufferSize * 2] = {};
-		//memcpy(m_finalSamples, m_sampleBuffer, sampleBufferSize * 8);
-		lowPass(m_finalSamples, m_sampleBuffer);
-		SDL_QueueAudio(m_audioDevice, (void*)m_finalSamples, sampleBufferSize*8);
-
-		while (SDL_GetQueuedAudioSize(m_audioDevice) > sampleBufferSize * 8)
-			(void)0;
+		m_mixedIndex = 0;
+		outputBlock();
+	}
+}
+
+void APU::outputBlock()
+{
+	//file sinks record emulated time, whatever speed we're running at. a device plays in real time, so off 1x it gets what the config asks for
+	float speed = m_sink->canPace() ? getDeviceSpeed() : 1.0f;
+	float resampleSpeed = 1.0f;
+	if (speed != 1.0f)
+	{
+		switch (Config::GBA.fastForwardAudio)
+		{
+		case FastForwardAudio::Mute:
+			return;
+		case FastForwardAudio::Drop:
+			//one block in every 'speed' - slow motion just plays each once and lets the device pad the gaps
+			m_dropAccumulator += 1.0f / speed;
+			if (m_dropAccumulator < 1.0f)
+				return;
+			m_dropAccumulator = std::min(m_dropAccumulator - 1.0f, 1.0f);
+			break;
+		case FastForwardAudio::Resample:
+			resampleSpeed = speed;
+			break;
+		}
+	}
+
+	if (resampleSpeed != m_resampleSpeed)
+	{
+		//squeezing the block into fewer output frames (or stretching it over more) shifts the pitch along with the speed
+		m_resampleSpeed = resampleSpeed;
+		int outputRate = (int)((float)m_outputSampleRate / resampleSpeed);		//the resampler keeps this above what its taps can span
+		m_resampler.setOutputRate(outputRate);
+		m_resampledBlock.resize(m_resampler.getMaxOutputFrames(sampleBlockSize) * 2);
 	}
 
-	m_scheduler->addEvent(Event::AudioSample, &APU::sampleEventCallback, (void*)this, m_scheduler->getEventTime() + cyclesPerSample);
+	uint32_t outputFrames = m_resampler.process(m_sampleBlock, sampleBlockSize, m_resampledBlock.data());
+	m_sink->write(m_resampledBlock.data(), outputFrames);
+	if (getPacingEmulation())
+		m_sink->waitForDevice();
+}
+
+float APU::getDeviceSpeed()
+{
+	//uncapped has no target, so go off what we're actually managing - capped at the slider's range, anything faster just overruns the ring
+	float speed = Config::GBA.disableVideoSync ? std::clamp((float)Config::GBA.achievedSpeed, 1.0f, 16.0f) : std::clamp(Config::GBA.speedMultiplier, 0.25f, 16.0f);
+	if (std::abs(speed - 1.0f) < 0.01f)
+		return 1.0f;
+	return speed;
+}
+
+void APU::updateMixerState()
+{
+	m_mixer.fifoShift[0] = 1 + ((SOUNDCNT_H >> 2) & 0b1);	//100% = left shift by 1 (*2), 50% = no change
+	m_mixer.fifoShift[1] = 1 + ((SOUNDCNT_H >> 3) & 0b1);
+	m_mixer.psgShift = 2 - (SOUNDCNT_H & 0b11);
+	if (m_mixer.psgShift < 0)			//3 is prohibited, treat it like 100%
+		m_mixer.psgShift = 0;
+
+	//bit positions of each channel's right enable. left is always the next bit up
+	static constexpr int enableBits[NumMixerChannels] = { 8 + 16, 12 + 16, 8, 9, 10, 11 };
+	uint32_t soundcnt = SOUNDCNT_L | (SOUNDCNT_H << 16);
+	for (int i = 0; i < NumMixerChannels; i++)
+	{
+		int leftBit = enableBits[i] + ((i < 2) ? 1 : 4);
+		m_mixer.rightMask[i] = ((soundcnt >> enableBits[i]) & 0b1) ? -1 : 0;
+		m_mixer.leftMask[i] = ((soundcnt >> leftBit) & 0b1) ? -1 : 0;
+	}
+}
+
+void APU::mixBlock(int endIndex)
+{
+	//mixes, clips and converts 8 frames per iteration. the highpass runs over the result afterwards, it's a running filter so can't be done in parallel
+	__m128i leftMask[NumMixerChannels], rightMask[NumMixerChannels], shift[NumMixerChannels];
+	for (int i = 0; i < NumMixerChannels; i++)
+	{
+		leftMask[i] = _mm_set1_epi16(m_mixer.leftMask[i]);
+		rightMask[i] = _mm_set1_epi16(m_mixer.rightMask[i]);
+		shift[i] = _mm_cvtsi32_si128((i < 2) ? m_mixer.fifoShift[i] : m_mixer.psgShift);
+	}
+	const __m128i clipMin = _mm_set1_epi16(-0x200);
+	const __m128i clipMax = _mm_set1_epi16(0x1FF);
+	const __m128 scale = _mm_set1_ps(512.f);
+
+	for (int i = m_mixedIndex; i < endIndex; i += 8)
+	{
+		__m128i left = _mm_setzero_si128(), right = _mm_setzero_si128();
+		for (int chan = 0; chan < NumMixerChannels; chan++)
+		{
+			__m128i sample = _mm_loadu_si128((const __m128i*)&m_channelBlock[chan][i]);
+			sample = (chan < 2) ? _mm_sll_epi16(sample, shift[chan]) : _mm_sra_epi16(sample, shift[chan]);
+			left = _mm_add_epi16(left, _mm_and_si128(sample, leftMask[chan]));
+			right = _mm_add_epi16(right, _mm_and_si128(sample, rightMask[chan]));
+		}
+		left = _mm_min_epi16(_mm_max_epi16(left, clipMin), clipMax);
+		right = _mm_min_epi16(_mm_max_epi16(right, clipMin), clipMax);
+
+		//interleave to L/R pairs, sign extend and convert
+		alignas(16) float mixed[16];
+		__m128i pairs[2] = { _mm_unpacklo_epi16(left, right), _mm_unpackhi_epi16(left, right) };
+		for (int j = 0; j < 2; j++)
+		{
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(pairs[j], pairs[j]), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(pairs[j], pairs[j]), 16);
+			_mm_store_ps(&mixed[j * 8], _mm_div_ps(_mm_cvtepi32_ps(lo), scale));
+			_mm_store_ps(&mixed[j * 8 + 4], _mm_div_ps(_mm_cvtepi32_ps(hi), scale));
+		}
+
+		int frames = std::min(8, endIndex - i);
+		for (int j = 0; j < frames * 2; j++)
+			m_sampleBlock[(i << 1) + j] = highPass(mixed[j]) / 8.f;
+	}
+	m_mixedIndex = endIndex;
 }
 
 void APU::onTimer0Overflow()
@@ -283,6 +425,7 @@ void APU::onTimer0Overflow()
 	bool soundEnabled = ((SOUNDCNT_X >> 7) & 0b1);
 	if (!soundEnabled)
 		return;
+	catchUp();		//fifo samples are about to change
 
 	bool channelATimerSelect = ((SOUNDCNT_H >> 10) & 0b1);
 	bool channelBTimerSelect = ((SOUNDCNT_H >> 14) & 0b1);
@@ -297,6 +440,7 @@ void APU::onTimer1Overflow()
 	bool soundEnabled = ((SOUNDCNT_X >> 7) & 0b1);
 	if (!soundEnabled)
 		return;
+	catchUp();		//fifo samples are about to change
 
 	bool channelATimerSelect = ((SOUNDCNT_H >> 10) & 0b1);
 	bool channelBTimerSelect = ((SOUNDCNT_H >> 14) & 0b1);
@@ -306,20 +450,20 @@ void APU::onTimer1Overflow()
 		updateDMAChannel(1);
 }
 
-void APU::updateSquare1()
+void APU::updateSquare1(uint64_t curTime)
 {
 	if (!m_square1.enabled)
 	{
 		m_square1.output = 0;
 		return;
 	}
-	uint64_t curTime = m_scheduler->getCurrentTimestamp();
 	uint64_t timeDiff = curTime - m_square1.lastCheckTimestamp;
 	while (timeDiff >= m_square1.frequency)
 	{
 		if (m_square1.frequency == 0)
 			break;
 		timeDiff -= m_square1.frequency;
+		m_square1.outputSum += m_square1.output * m_square1.frequency;		//level held up until this step
 		m_square1.dutyIdx++;
 		m_square1.dutyIdx &= 7;
 		m_square1.frequency = (2048 - (SOUND1CNT_X & 0x7FF)) * 16;
@@ -330,24 +474,25 @@ void APU::updateSquare1()
 			m_square1.output *= (m_square1.volume * 8);
 		}
 	}
+	m_square1.outputSum += m_square1.output * (int32_t)timeDiff;
 	m_square1.frequency -= timeDiff;
 	m_square1.lastCheckTimestamp = curTime;
 }
 
-void APU::updateSquare2()
+void APU::updateSquare2(uint64_t curTime)
 {
 	if (!m_square2.enabled)
 	{
 		m_square2.output = 0;
 		return;
 	}
-	uint64_t curTime = m_scheduler->getCurrentTimestamp();
 	uint64_t timeDiff = curTime - m_square2.lastCheckTimestamp;
 	while (timeDiff >= m_square2.frequency)
 	{
 		if (m_square2.frequency == 0)
 			break;
 		timeDiff -= m_square2.frequency;
+		m_square2.outputSum += m_square2.output * m_square2.frequency;		//level held up until this step
 		m_square2.dutyIdx++;
 		m_square2.dutyIdx &= 7;
 		m_square2.frequency = (2048 - (SOUND2CNT_H & 0x7FF)) * 16;
@@ -358,24 +503,25 @@ void APU::updateSquare2()
 			m_square2.output *= (m_square2.volume * 8);
 		}
 	}
+	m_square2.outputSum += m_square2.output * (int32_t)timeDiff;
 	m_square2.frequency -= timeDiff;
 	m_square2.lastCheckTimestamp = curTime;
 }
 
-void APU::updateWave()
+void APU::updateWave(uint64_t curTime)
 {
 	if (!m_waveChannel.enabled)
 	{
 		m_waveChannel.output = 0;
 		return;
 	}
-	uint64_t curTime = m_scheduler->getCurrentTimestamp();
 	uint64_t timeDiff = curTime - m_waveChannel.lastCheckTimestamp;
 	while (timeDiff >= m_waveChannel.frequency)
 	{
 		if (m_waveChannel.frequency == 0)
 			break;
 		timeDiff -= m_waveChannel.frequency;
+		m_waveChannel.outputSum += m_waveChannel.output * m_waveChannel.frequency;		//level held up until this step
 		m_waveChannel.frequency = (2048 - (SOUND3CNT_X & 0x7FF)) * 8;
 		m_waveChannel.output = 0;
 		if (m_waveChannel.enabled)
@@ -407,24 +553,25 @@ void APU::updateWave()
 		if (m_waveChannel.sampleIndex == 0 && m_waveChannel.twoDimensionBanking)
 			m_waveChannel.currentBankNumber = !m_waveChannel.currentBankNumber;
 	}
+	m_waveChannel.outputSum += m_waveChannel.output * (int32_t)timeDiff;
 	m_waveChannel.frequency -= timeDiff;
 	m_waveChannel.lastCheckTimestamp = curTime;
 }
 
-void APU::updateNoise()
+void APU::updateNoise(uint64_t curTime)
 {
 	if (!m_noiseChannel.enabled)
 	{
 		m_noiseChannel.output = 0;
 		return;
 	}
-	uint64_t curTime = m_scheduler->getCurrentTimestamp();
 	uint64_t timeDiff = curTime - m_noiseChannel.lastCheckTimestamp;
 	while (timeDiff >= m_noiseChannel.frequency)
 	{
 		if (m_noiseChannel.frequency == 0)
 			break;
 		timeDiff -= m_noiseChannel.frequency;
+		m_noiseChannel.outputSum += m_noiseChannel.output * m_noiseChannel.frequency;		//level held up until this step
 		int divisor = divisorMappings[m_noiseChannel.divisorCode];
 		m_noiseChannel.frequency = divisor << (m_noiseChannel.shiftAmount + 2);	//same situation with the '+2'
 		m_noiseChannel.output = 0;
@@ -448,12 +595,14 @@ void APU::updateNoise()
 				m_noiseChannel.LFSR &= 0x7F;
 		}
 	}
+	m_noiseChannel.outputSum += m_noiseChannel.output * (int32_t)timeDiff;
 	m_noiseChannel.frequency -= timeDiff;
 	m_noiseChannel.lastCheckTimestamp = curTime;
 }
 
 void APU::onFrameSequencerEvent()
 {
+	catchUp();
 	if ((frameSequencerClock & 1) == 0)
 		clockLengthCounters();
 	if ((frameSequencerClock & 7) == 7)
@@ -462,7 +611,7 @@ void APU::onFrameSequencerEvent()
 		clockFrequencySweep();
 
 	frameSequencerClock = (frameSequencerClock + 1) & 7;
-	m_scheduler->addEvent(Event::FrameSequencer, &APU::frameSequencerCallback, (void*)this, m_scheduler->getEventTime() + 32768);
+	m_scheduler.addEvent(Event::FrameSequencer, &APU::frameSequencerCallback, (void*)this, m_scheduler.getEventTime() + 32768);
 }
 
 void APU::clockLengthCounters()
@@ -619,7 +768,9 @@ void APU::resetAllChannels()
 	SOUNDCNT_X &= ~0xF;	//clear PSG channel enable bits
 
 	//all PSG channel registers now reset to 0
+	mixBlock(sampleIndex);
 	SOUNDCNT_L = {};
+	updateMixerState();
 
 	SOUND1CNT_L = {};
 	SOUND1CNT_H = {};
@@ -648,10 +799,10 @@ void APU::updateDMAChannel(int channel)
 	m_channels[channel].popSample();
 }
 
-void APU::sampleEventCallback(void* context)
+void APU::blockEventCallback(void* context)
 {
 	APU* thisPtr = (APU*)context;
-	thisPtr->onSampleEvent();
+	thisPtr->onBlockEvent();
 }
 
 void APU::timer0Callback(void* context)
@@ -689,7 +840,7 @@ void APU::triggerSquare1()
 	m_square1.doLength = ((SOUND1CNT_X >> 14) & 0b1);
 	m_square1.envelopeTimer = m_square1.envelopePeriod;
 	m_square1.volume = ((SOUND1CNT_H >> 12) & 0xF);
-	m_square1.lastCheckTimestamp = m_scheduler->getCurrentTimestamp();
+	m_square1.lastCheckTimestamp = m_scheduler.getCurrentTimestamp();
 }
 
 void APU::triggerSquare2()
@@ -704,7 +855,7 @@ void APU::triggerSquare2()
 	m_square2.doLength = ((SOUND2CNT_H >> 14) & 0b1);
 	m_square2.envelopeTimer = m_square2.envelopePeriod;
 	m_square2.volume = ((SOUND2CNT_L >> 12) & 0xF);
-	m_square2.lastCheckTimestamp = m_scheduler->getCurrentTimestamp();
+	m_square2.lastCheckTimestamp = m_scheduler.getCurrentTimestamp();
 }
 
 void APU::triggerWave()
@@ -718,7 +869,7 @@ void APU::triggerWave()
 	m_waveChannel.sampleIndex = 0;
 	m_waveChannel.currentBankNumber = (SOUND3CNT_L >> 6) & 0b1;	//todo: doublecheck if this is right;
 	m_waveChannel.doLength = ((SOUND3CNT_X >> 14) & 0b1);
-	m_waveChannel.lastCheckTimestamp = m_scheduler->getCurrentTimestamp();
+	m_waveChannel.lastCheckTimestamp = m_scheduler.getCurrentTimestamp();
 }
 
 void APU::triggerNoise()
@@ -735,15 +886,7 @@ void APU::triggerNoise()
 
 	int divisor = divisorMappings[m_noiseChannel.divisorCode];
 	m_noiseChannel.frequency = divisor << (m_noiseChannel.shiftAmount + 2);	//<-- +2 accounts for us measuring cycles at 16.7MHz
-	m_noiseChannel.lastCheckTimestamp = m_scheduler->getCurrentTimestamp();
-}
-
-float APU::clipSample(int16_t sampleIn)
-{
-	sampleIn = std::max(sampleIn, (int16_t)-0x200);
-	sampleIn = std::min(sampleIn, (int16_t)0x1FF);
-	float sampleOut = (float)sampleIn / 512.f;
-	return highPass(sampleOut) / 8.f;
+	m_noiseChannel.lastCheckTimestamp = m_scheduler.getCurrentTimestamp();
 }
 
 float APU::highPass(float in)
@@ -754,19 +897,10 @@ float APU::highPass(float in)
 	return out;
 }
 
-void APU::lowPass(float* outBuffer, float* inBuffer)
+bool APU::getPacingEmulation()
 {
-	float dt = 1.0 / (float)sampleRate;
-	float cutoff = 20000;
-	float a = (2.0 * 3.14 * cutoff * dt) / ((2.0 * 3.14 * cutoff * dt) + 1.0);
-	outBuffer[0] = a * inBuffer[0];
-	outBuffer[1] = a * inBuffer[1];
-
-	for (int i = 1; i < sampleBufferSize; i++)
-	{
-		outBuffer[i * 2] = outBuffer[(i * 2) - 2] + a * (inBuffer[i * 2] - outBuffer[(i * 2) - 2]);
-		outBuffer[(i * 2) + 1] = outBuffer[(i * 2) - 1] + a * (inBuffer[(i * 2) + 1] - outBuffer[(i * 2) - 1]);
-	}
+	//never wait on the device if we're meant to be running flat out, or at anything other than real speed
+	return Config::GBA.audioSync && m_sink->canPace() && !Config::GBA.disableVideoSync && !Config::GBA.noVideo && getDeviceSpeed() == 1.0f;
 }
 
 void APU::advanceSamplePtr(int channel)
@@ -2,10 +2,11 @@
 
 #include"Logger.h"
 #include"Scheduler.h"
+#include"Config.h"
+#include"AudioSink.h"
+#include"AudioResampler.h"
 
 #include<iostream>
-#include<SDL.h>
-#undef main			//really sdl??
 
 typedef void(*FIFOcallbackFn)(void*, int);
 
@@ -116,6 +117,7 @@ struct SquareChannel1
 	bool sweepNegate;
 
 	uint64_t lastCheckTimestamp;
+	int32_t outputSum;		//output integrated over cycles since the last sample
 };
 
 struct SquareChannel2
@@ -135,6 +137,7 @@ struct SquareChannel2
 	bool envelopeIncrease;
 
 	uint64_t lastCheckTimestamp;
+	int32_t outputSum;		//output integrated over cycles since the last sample
 };
 
 struct WaveChannel
@@ -153,6 +156,7 @@ struct WaveChannel
 	uint8_t waveRam[2][16];	//two banks of wave ram, each holds 32 4 bit samples
 
 	uint64_t lastCheckTimestamp;
+	int32_t outputSum;		//output integrated over cycles since the last sample
 };
 
 struct NoiseChannel
@@ -174,12 +178,13 @@ struct NoiseChannel
 	bool envelopeIncrease;
 
 	uint64_t lastCheckTimestamp;
+	int32_t outputSum;		//output integrated over cycles since the last sample
 };
 
 class APU
 {
 public:
-	APU(std::shared_ptr<Scheduler> scheduler);
+	APU(Scheduler& scheduler);
 	~APU();
 
 	void registerDMACallback(FIFOcallbackFn dmaCallback, void* context);
@@ -187,14 +192,15 @@ public:
 	uint8_t readIO(uint32_t address);
 	void writeIO(uint32_t address, uint8_t value);
 
-	static void sampleEventCallback(void* context);
+	static void blockEventCallback(void* context);
 	static void frameSequencerCallback(void* context);
 	static void timer0Callback(void* context);
 	static void timer1Callback(void* context);
 
 	void advanceSamplePtr(int channel);
+	bool getPacingEmulation();		//whether the audio device is what's keeping emulation at real speed
 private:
-	std::shared_ptr<Scheduler> m_scheduler;
+	Scheduler& m_scheduler;
 	AudioFIFO m_channels[2];
 
 	SquareChannel1 m_square1 = {};
@@ -228,7 +234,7 @@ private:
 
 	static constexpr int cyclesPerSample = 256;	//~64KHz sample rate, so we want to mix samples together roughly every that many cycles
 	static constexpr int sampleRate = 65536;
-	static constexpr int sampleBufferSize = 2048;
+	static constexpr int sampleBlockSize = 256;		//frames mixed before they're handed to the sink
 
 	static constexpr uint8_t dutyTable[4] =		//fixed duty table for square wave channels
 	{
@@ -245,13 +251,17 @@ private:
 	FIFOcallbackFn FIFODMACallback;
 	void* dmaContext;
 
-	void onSampleEvent();
+	//output is rendered lazily: only when something audible is about to change, and once per block so the sink keeps getting fed
+	void onBlockEvent();
+	void catchUp();
+	void renderSample(uint64_t timestamp);
+	void scheduleBlockEvent();
 	void onTimer0Overflow();
 	void onTimer1Overflow();
-	void updateSquare1();
-	void updateSquare2();
-	void updateWave();
-	void updateNoise();
+	void updateSquare1(uint64_t curTime);
+	void updateSquare2(uint64_t curTime);
+	void updateWave(uint64_t curTime);
+	void updateNoise(uint64_t curTime);
 	void onFrameSequencerEvent();
 
 	//Frameseq related stuff
@@ -265,12 +275,35 @@ private:
 	void resetAllChannels();
 
 
-	SDL_AudioDeviceID m_audioDevice = {};
-	float m_sampleBuffer[sampleBufferSize*2] = {};
+	std::unique_ptr<AudioSink> m_sink;
+	int m_outputSampleRate = 0;
+	AudioResampler m_resampler;
+	float m_sampleBlock[sampleBlockSize * 2] = {};
+	std::vector<float> m_resampledBlock;
+	float m_resampleSpeed = 1.0f;		//speed the resampler's output rate is currently set up for
+	float m_dropAccumulator = 0.0f;		//blocks owed to the device when dropping audio off 1x
+	void outputBlock();
+	float getDeviceSpeed();				//speed the device is being fed at, 1.0 when it's near enough real time
 	int sampleIndex = 0;
+	uint64_t m_nextSampleTimestamp = cyclesPerSample;	//end of the next sample period that hasn't been rendered yet
+
+	//channel outputs are kept per block and mixed 8 frames at a time. the padding lets the last group of a partial mix read past the end
+	enum MixerChannel { FIFOA, FIFOB, Square1, Square2, Wave, Noise, NumMixerChannels };
+	alignas(16) int16_t m_channelBlock[NumMixerChannels][sampleBlockSize + 8] = {};
+	int m_mixedIndex = 0;		//frames of the current block already mixed into m_sampleBlock
+
+	//soundcnt decoded once per write, rather than for every sample
+	struct MixerState
+	{
+		int16_t leftMask[NumMixerChannels];		//0xFFFF if the channel goes to that side, 0 if not
+		int16_t rightMask[NumMixerChannels];
+		int fifoShift[2];
+		int psgShift;
+	};
+	MixerState m_mixer = {};
+	void updateMixerState();
+	void mixBlock(int endIndex);
 
-	float clipSample(int16_t sampleIn);
 	float capacitor = 0.0f;
 	float highPass(float in);
-	void lowPass(float* outBuffer, float* inBuffer);
 };
\ No newline at end of file
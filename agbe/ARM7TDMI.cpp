@@ -1,10 +1,7 @@
 #include"ARM7TDMI.h"
 
-ARM7TDMI::ARM7TDMI(std::shared_ptr<Bus> bus, std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler)
+ARM7TDMI::ARM7TDMI(Bus& bus, InterruptManager& interruptManager, Scheduler& scheduler) : m_bus(bus), m_interruptManager(interruptManager), m_scheduler(scheduler)
 {
-	m_bus = bus;
-	m_interruptManager = interruptManager;
-	m_scheduler = scheduler;
 	CPSR = 0x13;				//starts in svc mode upon boot?
 	m_lastCheckModeBits = 0x13;
 	for (int i = 0; i < 16; i++)
@@ -23,43 +20,43 @@ ARM7TDMI::~ARM7TDMI()
 
 }
 
-consteval std::array<ARM7TDMI::instructionFn, 4096> ARM7TDMI::genARMTable()
+template<bool debug> consteval std::array<ARM7TDMI::instructionFn, 4096> ARM7TDMI::genARMTable()
 {
 	std::array<instructionFn, 4096> armTable;
 	armTable.fill((instructionFn)&ARM7TDMI::ARM_Undefined);
 	//bypass compiler recursion limit by splitting up into 256 long chunks of filling the table
-	setARMTableEntries<0, 256>(armTable);
-	setARMTableEntries<256, 512>(armTable);
-	setARMTableEntries<512, 768>(armTable);
-	setARMTableEntries<768, 1024>(armTable);
-	setARMTableEntries<1024, 1280>(armTable);
-	setARMTableEntries<1280, 1536>(armTable);
-	setARMTableEntries<1536, 1792>(armTable);
-	setARMTableEntries<1792, 2048>(armTable);
-	setARMTableEntries<2048, 2304>(armTable);
-	setARMTableEntries<2304, 2560>(armTable);
-	setARMTableEntries<2560, 2816>(armTable);
-	setARMTableEntries<2816, 3072>(armTable);
-	setARMTableEntries<3072, 3328>(armTable);
-	setARMTableEntries<3328, 3584>(armTable);
-	setARMTableEntries<3584, 3840>(armTable);
-	setARMTableEntries<3840, 4096>(armTable);
+	setARMTableEntries<debug, 0, 256>(armTable);
+	setARMTableEntries<debug, 256, 512>(armTable);
+	setARMTableEntries<debug, 512, 768>(armTable);
+	setARMTableEntries<debug, 768, 1024>(armTable);
+	setARMTableEntries<debug, 1024, 1280>(armTable);
+	setARMTableEntries<debug, 1280, 1536>(armTable);
+	setARMTableEntries<debug, 1536, 1792>(armTable);
+	setARMTableEntries<debug, 1792, 2048>(armTable);
+	setARMTableEntries<debug, 2048, 2304>(armTable);
+	setARMTableEntries<debug, 2304, 2560>(armTable);
+	setARMTableEntries<debug, 2560, 2816>(armTable);
+	setARMTableEntries<debug, 2816, 3072>(armTable);
+	setARMTableEntries<debug, 3072, 3328>(armTable);
+	setARMTableEntries<debug, 3328, 3584>(armTable);
+	setARMTableEntries<debug, 3584, 3840>(armTable);
+	setARMTableEntries<debug, 3840, 4096>(armTable);
 
 	return armTable;
 }
 
-consteval std::array<ARM7TDMI::instructionFn, 1024> ARM7TDMI::genThumbTable()
+template<bool debug> consteval std::array<ARM7TDMI::instructionFn, 1024> ARM7TDMI::genThumbTable()
 {
 	std::array<instructionFn, 1024> thumbTable;
 	thumbTable.fill((instructionFn)&ARM7TDMI::ARM_Undefined);
-	setThumbTableEntries<0, 256>(thumbTable);
-	setThumbTableEntries<256, 512>(thumbTable);
-	setThumbTableEntries<512, 768>(thumbTable);
-	setThumbTableEntries<768, 1024>(thumbTable);
+	setThumbTableEntries<debug, 0, 256>(thumbTable);
+	setThumbTableEntries<debug, 256, 512>(thumbTable);
+	setThumbTableEntries<debug, 512, 768>(thumbTable);
+	setThumbTableEntries<debug, 768, 1024>(thumbTable);
 	return thumbTable;
 }
 
-void ARM7TDMI::step()
+template<bool debug> void ARM7TDMI::step()
 {
 	fetch();
 	if (dispatchInterrupt())	//if interrupt was dispatched then fetch new opcode (dispatchInterrupt already flushes pipeline !)
@@ -72,9 +69,9 @@ void ARM7TDMI::step()
 	switch (m_inThumbMode)
 	{
 	case 0:
-		executeARM(); break;
+		executeARM<debug>(); break;
 	case 1:
-		executeThumb(); break;
+		executeThumb<debug>(); break;
 	}
 
 	if (!m_pipelineFlushed)
@@ -85,7 +82,7 @@ void ARM7TDMI::step()
 	}
 	else
 		refillPipeline();
-	m_scheduler->tick();
+	m_scheduler.tick();
 }
 
 void ARM7TDMI::fetch()
@@ -93,14 +90,14 @@ void ARM7TDMI::fetch()
 	int curPipelinePtr = m_pipelinePtr;
 	m_pipeline[curPipelinePtr].state = PipelineState::FILLED;
 	if (m_inThumbMode)
-		m_pipeline[curPipelinePtr].opcode = m_bus->fetch16(R[15],(AccessType)!nextFetchNonsequential);
+		m_pipeline[curPipelinePtr].opcode = m_bus.fetch16(R[15],(AccessType)!nextFetchNonsequential);
 	else
-		m_pipeline[curPipelinePtr].opcode = m_bus->fetch32(R[15],(AccessType)!nextFetchNonsequential);
+		m_pipeline[curPipelinePtr].opcode = m_bus.fetch32(R[15],(AccessType)!nextFetchNonsequential);
 
 	nextFetchNonsequential = false;
 }
 
-void ARM7TDMI::executeARM()
+template<bool debug> void ARM7TDMI::executeARM()
 {
 	pipelineFull = true;
 	//check conditions before executing
@@ -109,19 +106,19 @@ void ARM7TDMI::executeARM()
 	bool conditionMet = (conditionLUT[(CPSR >> 28) & 0xF] >> conditionCode) & 0b1;
 	if (conditionMet) [[likely]]
 	{
-		static constexpr auto armTable = genARMTable();
+		static constexpr auto armTable = genARMTable<debug>();
 		uint32_t lookup = ((m_currentOpcode & 0x0FF00000) >> 16) | ((m_currentOpcode & 0xF0) >> 4);	//bits 20-27 shifted down to bits 4-11. bits 4-7 shifted down to bits 0-4
 		instructionFn instr = armTable[lookup];
 		(this->*instr)();
 	}
 	else
-		m_scheduler->addCycles(1);		//condition not met: 1seq/nonseq just for the instruction fetch probs.
+		m_scheduler.addCycles(1);		//condition not met: 1seq/nonseq just for the instruction fetch probs.
 }
 
-void ARM7TDMI::executeThumb()
+template<bool debug> void ARM7TDMI::executeThumb()
 {
 	pipelineFull = true;
-	static constexpr auto thumbTable = genThumbTable();
+	static constexpr auto thumbTable = genThumbTable<debug>();
 	uint16_t lookup = m_currentOpcode >> 6;
 	instructionFn instr = thumbTable[lookup];
 	(this->*instr)();
@@ -129,7 +126,7 @@ void ARM7TDMI::executeThumb()
 
 bool ARM7TDMI::dispatchInterrupt()
 {
-	if (((CPSR>>7)&0b1) || !m_interruptManager->getInterrupt() || !m_interruptManager->getInterruptsEnabled())
+	if (((CPSR>>7)&0b1) || !m_interruptManager.getInterrupt() || !m_interruptManager.getInterruptsEnabled())
 		return false;	//only dispatch if pipeline full (or not about to flush)
 	//irq bits: 10010
 	uint32_t oldCPSR = CPSR;
@@ -151,7 +148,7 @@ bool ARM7TDMI::dispatchInterrupt()
 void ARM7TDMI::flushPipeline()
 {
 	m_pipelineFlushed = true;
-	m_bus->invalidatePrefetchBuffer();
+	m_bus.invalidatePrefetchBuffer();
 	pipelineFull = false;
 }
 
@@ -163,14 +160,14 @@ void ARM7TDMI::refillPipeline()
 	{
 	case 0:		//refill ARM
 		R[15] &= ~0b11;
-		m_pipeline[0].opcode = m_bus->fetch32(R[15], AccessType::Nonsequential);
-		m_pipeline[1].opcode = m_bus->fetch32(R[15] + 4, AccessType::Sequential);
+		m_pipeline[0].opcode = m_bus.fetch32(R[15], AccessType::Nonsequential);
+		m_pipeline[1].opcode = m_bus.fetch32(R[15] + 4, AccessType::Sequential);
 		R[15] += 8;
 		break;
 	case 1:		//refill thumb
 		R[15] &= ~0b1;
-		m_pipeline[0].opcode = m_bus->fetch16(R[15], AccessType::Nonsequential);
-		m_pipeline[1].opcode = m_bus->fetch16(R[15] + 2, AccessType::Sequential);
+		m_pipeline[0].opcode = m_bus.fetch16(R[15], AccessType::Nonsequential);
+		m_pipeline[1].opcode = m_bus.fetch16(R[15] + 2, AccessType::Sequential);
 		R[15] += 4;
 		break;
 	}
@@ -181,7 +178,7 @@ void ARM7TDMI::refillPipeline()
 	m_pipeline[2].state = PipelineState::UNFILLED;	//this will be filled upon next FDE cycle
 	m_pipelinePtr = 2;
 
-	m_scheduler->tick();
+	m_scheduler.tick();
 }
 
 //misc flag stuff
@@ -368,4 +365,8 @@ int ARM7TDMI::calculateMultiplyCycles(uint32_t operand, bool isSigned)
 	else if ((operand >> 24) == 0)
 		totalCycles = 3;
 	return totalCycles;
-}
\ No newline at end of file
+}
+
+//one per run loop, see GBA::runLoop
+template void ARM7TDMI::step<false>();
+template void ARM7TDMI::step<true>();
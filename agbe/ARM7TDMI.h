@@ -24,15 +24,16 @@ struct Pipeline
 class ARM7TDMI
 {
 public:
-	ARM7TDMI(std::shared_ptr<Bus> bus, std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler);
+	ARM7TDMI(Bus& bus, InterruptManager& interruptManager, Scheduler& scheduler);
 	~ARM7TDMI();
 
-	void step();
+	template<bool debug> void step();		//debug = the debugger's run loop, where loads/stores check watchpoints
+	uint32_t getExecutingPC() { return R[15] - (incrAmountLUT[m_inThumbMode] * 2); }	//address of the instruction the next step() executes (pipeline is always full between steps)
 private:
 	static constexpr int incrAmountLUT[2] = { 4,2 };
-	std::shared_ptr<Bus> m_bus;
-	std::shared_ptr<InterruptManager> m_interruptManager;
-	std::shared_ptr<Scheduler> m_scheduler;
+	Bus& m_bus;
+	InterruptManager& m_interruptManager;
+	Scheduler& m_scheduler;
 
 	Pipeline m_pipeline[3];
 	uint8_t m_pipelinePtr = 0;
@@ -59,8 +60,8 @@ private:
 	void flushPipeline();
 	void refillPipeline();
 
-	void executeARM();
-	void executeThumb();
+	template<bool debug> void executeARM();
+	template<bool debug> void executeThumb();
 
 	bool dispatchInterrupt();
 
@@ -95,13 +96,13 @@ private:
 	void ARM_PSRTransfer();
 	void ARM_Multiply();
 	void ARM_MultiplyLong();
-	void ARM_SingleDataSwap();
+	template<bool debug> void ARM_SingleDataSwap();
 	void ARM_BranchExchange();
-	void ARM_HalfwordTransferRegisterOffset();
-	void ARM_HalfwordTransferImmediateOffset();
-	void ARM_SingleDataTransfer();
+	template<bool debug> void ARM_HalfwordTransferRegisterOffset();
+	template<bool debug> void ARM_HalfwordTransferImmediateOffset();
+	template<bool debug> void ARM_SingleDataTransfer();
 	void ARM_Undefined();
-	void ARM_BlockDataTransfer();
+	template<bool debug> void ARM_BlockDataTransfer();
 	void ARM_CoprocessorDataTransfer();
 	void ARM_CoprocessorDataOperation();
 	void ARM_CoprocessorRegisterTransfer();
@@ -113,16 +114,16 @@ private:
 	void Thumb_MoveCompareAddSubtractImm();
 	void Thumb_ALUOperations();
 	void Thumb_HiRegisterOperations();
-	void Thumb_PCRelativeLoad();
-	void Thumb_LoadStoreRegisterOffset();
-	void Thumb_LoadStoreSignExtended();
-	void Thumb_LoadStoreImmediateOffset();
-	void Thumb_LoadStoreHalfword();
-	void Thumb_SPRelativeLoadStore();
+	template<bool debug> void Thumb_PCRelativeLoad();
+	template<bool debug> void Thumb_LoadStoreRegisterOffset();
+	template<bool debug> void Thumb_LoadStoreSignExtended();
+	template<bool debug> void Thumb_LoadStoreImmediateOffset();
+	template<bool debug> void Thumb_LoadStoreHalfword();
+	template<bool debug> void Thumb_SPRelativeLoadStore();
 	void Thumb_LoadAddress();
 	void Thumb_AddOffsetToStackPointer();
-	void Thumb_PushPopRegisters();
-	void Thumb_MultipleLoadStore();
+	template<bool debug> void Thumb_PushPopRegisters();
+	template<bool debug> void Thumb_MultipleLoadStore();
 	void Thumb_ConditionalBranch();
 	void Thumb_SoftwareInterrupt();
 	void Thumb_UnconditionalBranch();
@@ -143,7 +144,7 @@ private:
 
 	//magic code for generating compile time arm/thumb luts
 
-	template<int i, int max> static consteval void setARMTableEntries(auto& table)
+	template<bool debug, int i, int max> static consteval void setARMTableEntries(auto& table)
 	{
 		uint32_t tempOpcode = ((i & 0xFF0) << 16) | ((i & 0xF) << 4);	//expand instruction so bits 20-27 contain top 8 bits of i, bits 4-7 contain lower 4 bits
 		if ((tempOpcode & 0b0000'1110'0000'0000'0000'0000'0000'0000) == 0b0000'1010'0000'0000'0000'0000'0000'0000)
@@ -153,11 +154,11 @@ private:
 		else if ((tempOpcode & 0b0000'1111'1000'0000'0000'0000'1111'0000) == 0b0000'0000'1000'0000'0000'0000'1001'0000)
 			table[i] = (instructionFn)&ARM7TDMI::ARM_MultiplyLong;
 		else if ((tempOpcode & 0b0000'1111'1011'0000'0000'1111'1111'0000) == 0b0000'0001'0000'0000'0000'0000'1001'0000)
-			table[i] = (instructionFn)&ARM7TDMI::ARM_SingleDataSwap;
+			table[i] = (instructionFn)&ARM7TDMI::ARM_SingleDataSwap<debug>;
 		else if ((tempOpcode & 0b0000'1110'0100'0000'0000'1111'1001'0000) == 0b0000'0000'0000'0000'0000'0000'1001'0000)
-			table[i] = (instructionFn)&ARM7TDMI::ARM_HalfwordTransferRegisterOffset;
+			table[i] = (instructionFn)&ARM7TDMI::ARM_HalfwordTransferRegisterOffset<debug>;
 		else if ((tempOpcode & 0b0000'1110'0100'0000'0000'0000'1001'0000) == 0b0000'0000'0100'0000'0000'0000'1001'0000)
-			table[i] = (instructionFn)&ARM7TDMI::ARM_HalfwordTransferImmediateOffset;
+			table[i] = (instructionFn)&ARM7TDMI::ARM_HalfwordTransferImmediateOffset<debug>;
 		else if ((tempOpcode & 0b0000'1111'1111'0000'0000'0000'1111'0000) == 0b0000'0001'0010'0000'0000'0000'0001'0000)
 			table[i] = (instructionFn)&ARM7TDMI::ARM_BranchExchange;
 		else if ((tempOpcode & 0b0000'1100'0000'0000'0000'0000'0000'0000) == 0b0000'0000'0000'0000'0000'0000'0000'0000)
@@ -165,9 +166,9 @@ private:
 		else if ((tempOpcode & 0b0000'1110'0000'0000'0000'0000'0001'0000) == 0b0000'0110'0000'0000'0000'0000'0001'0000)
 			table[i] = (instructionFn)&ARM7TDMI::ARM_Undefined;
 		else if ((tempOpcode & 0b0000'1100'0000'0000'0000'0000'0000'0000) == 0b0000'0100'0000'0000'0000'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::ARM_SingleDataTransfer;
+			table[i] = (instructionFn)&ARM7TDMI::ARM_SingleDataTransfer<debug>;
 		else if ((tempOpcode & 0b0000'1110'0000'0000'0000'0000'0000'0000) == 0b0000'1000'0000'0000'0000'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::ARM_BlockDataTransfer;
+			table[i] = (instructionFn)&ARM7TDMI::ARM_BlockDataTransfer<debug>;
 		else if ((tempOpcode & 0b0000'1110'0000'0000'0000'0000'0000'0000) == 0b0000'1100'0000'0000'0000'0000'0000'0000)
 			table[i] = (instructionFn)&ARM7TDMI::ARM_CoprocessorDataTransfer;
 		else if ((tempOpcode & 0b0000'1111'0000'0000'0000'0000'0001'0000) == 0b0000'1110'0000'0000'0000'0000'0000'0000)
@@ -178,10 +179,10 @@ private:
 			table[i] = (instructionFn)&ARM7TDMI::ARM_SoftwareInterrupt;
 
 		if constexpr ((i + 1) < max)
-			setARMTableEntries<i + 1, max>(table);
+			setARMTableEntries<debug, i + 1, max>(table);
 	}
 
-	template<int i, int max> static consteval void setThumbTableEntries(auto& table)
+	template<bool debug, int i, int max> static consteval void setThumbTableEntries(auto& table)
 	{
 		uint16_t tempOpcode = (i << 6);
 		if ((tempOpcode & 0b1111'1000'0000'0000) == 0b0001'1000'0000'0000)
@@ -195,25 +196,25 @@ private:
 		else if ((tempOpcode & 0b1111'1100'0000'0000) == 0b0100'0100'0000'0000)
 			table[i] = (instructionFn)&ARM7TDMI::Thumb_HiRegisterOperations;
 		else if ((tempOpcode & 0b1111'1000'0000'0000) == 0b0100'1000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_PCRelativeLoad;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_PCRelativeLoad<debug>;
 		else if ((tempOpcode & 0b1111'0010'0000'0000) == 0b0101'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreRegisterOffset;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreRegisterOffset<debug>;
 		else if ((tempOpcode & 0b1111'0010'0000'0000) == 0b0101'0010'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreSignExtended;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreSignExtended<debug>;
 		else if ((tempOpcode & 0b1110'0000'0000'0000) == 0b0110'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreImmediateOffset;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreImmediateOffset<debug>;
 		else if ((tempOpcode & 0b1111'0000'0000'0000) == 0b1000'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreHalfword;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadStoreHalfword<debug>;
 		else if ((tempOpcode & 0b1111'0000'0000'0000) == 0b1001'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_SPRelativeLoadStore;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_SPRelativeLoadStore<debug>;
 		else if ((tempOpcode & 0b1111'0000'0000'0000) == 0b1010'0000'0000'0000)
 			table[i] = (instructionFn)&ARM7TDMI::Thumb_LoadAddress;
 		else if ((tempOpcode & 0b1111'1111'0000'0000) == 0b1011'0000'0000'0000)
 			table[i] = (instructionFn)&ARM7TDMI::Thumb_AddOffsetToStackPointer;
 		else if ((tempOpcode & 0b1111'0110'0000'0000) == 0b1011'0100'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_PushPopRegisters;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_PushPopRegisters<debug>;
 		else if ((tempOpcode & 0b1111'0000'0000'0000) == 0b1100'0000'0000'0000)
-			table[i] = (instructionFn)&ARM7TDMI::Thumb_MultipleLoadStore;
+			table[i] = (instructionFn)&ARM7TDMI::Thumb_MultipleLoadStore<debug>;
 		else if ((tempOpcode & 0b1111'1111'0000'0000) == 0b1101'1111'0000'0000)
 			table[i] = (instructionFn)&ARM7TDMI::Thumb_SoftwareInterrupt;
 		else if ((tempOpcode & 0b1111'0000'0000'0000) == 0b1101'0000'0000'0000)
@@ -228,11 +229,12 @@ private:
 		}
 
 		if constexpr ((i + 1) < max)
-			setThumbTableEntries<i+1, max>(table);
+			setThumbTableEntries<debug, i+1, max>(table);
 	}
 
-	static consteval std::array<instructionFn, 4096> genARMTable();
-	static consteval std::array<instructionFn, 1024> genThumbTable();
+	//one table per run loop. they only differ in the load/store handlers
+	template<bool debug> static consteval std::array<instructionFn, 4096> genARMTable();
+	template<bool debug> static consteval std::array<instructionFn, 1024> genThumbTable();
 
 	//messy.. generates 16x16 LUT covering all combinations of CPSR flags and condition codes (reduces extra call at runtime)
 	static consteval std::array<uint16_t, 16> genConditionCodeTable()
@@ -14,7 +14,7 @@ void ARM7TDMI::ARM_Branch()
 	if (link)
 		setReg(14, (oldR15 - 4) & ~0b11);	
 
-	m_scheduler->addCycles(3);
+	m_scheduler.addCycles(3);
 }
 
 void ARM7TDMI::ARM_DataProcessing()
@@ -60,8 +60,8 @@ void ARM7TDMI::ARM_DataProcessing()
 		int shiftAmount = 0;
 		if (shiftIsRegister)
 		{
-			m_scheduler->addCycles(1);
-			m_bus->tickPrefetcher(1);
+			m_scheduler.addCycles(1);
+			m_bus.tickPrefetcher(1);
 			nextFetchNonsequential = true;
 			if (op2Idx == 15)	//account for R15 being 12 bytes ahead if register-specified shift amount
 				operand2 += 4;
@@ -191,7 +191,7 @@ void ARM7TDMI::ARM_DataProcessing()
 
 	if (destRegIdx == 15)
 	{
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		nextFetchNonsequential = true;
 		if (setCPSR)
 		{
@@ -208,7 +208,7 @@ void ARM7TDMI::ARM_DataProcessing()
 
 	}
 
-	m_scheduler->addCycles(1);
+	m_scheduler.addCycles(1);
 }
 
 void ARM7TDMI::ARM_PSRTransfer()
@@ -280,7 +280,7 @@ void ARM7TDMI::ARM_PSRTransfer()
 			setReg(destReg, CPSR);
 		}
 	}
-	m_scheduler->addCycles(1);
+	m_scheduler.addCycles(1);
 }
 
 void ARM7TDMI::ARM_Multiply()
@@ -315,8 +315,8 @@ void ARM7TDMI::ARM_Multiply()
 	if (accumulate)
 		internalCycles++;
 
-	m_scheduler->addCycles(internalCycles + 1);
-	m_bus->tickPrefetcher(internalCycles);
+	m_scheduler.addCycles(internalCycles + 1);
+	m_bus.tickPrefetcher(internalCycles);
 	nextFetchNonsequential = true;	//hm
 }
 
@@ -366,14 +366,14 @@ void ARM7TDMI::ARM_MultiplyLong()
 	if (accumulate)
 		internalCycles++;
 
-	m_scheduler->addCycles(internalCycles + 1);
-	m_bus->tickPrefetcher(internalCycles);
+	m_scheduler.addCycles(internalCycles + 1);
+	m_bus.tickPrefetcher(internalCycles);
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::ARM_SingleDataSwap()
+template<bool debug> void ARM7TDMI::ARM_SingleDataSwap()
 {
-	m_bus->setBusLocked(true);
+	m_bus.setBusLocked(true);
 	bool byteWord = ((m_currentOpcode >> 22) & 0b1);
 	uint8_t baseRegIdx = ((m_currentOpcode >> 16) & 0xF);
 	uint8_t destRegIdx = ((m_currentOpcode >> 12) & 0xF);
@@ -384,24 +384,24 @@ void ARM7TDMI::ARM_SingleDataSwap()
 
 	if (byteWord)		//swap byte
 	{
-		uint8_t swapVal = m_bus->read8(swapAddress,AccessType::Nonsequential);
-		m_bus->write8(swapAddress, srcData & 0xFF, AccessType::Nonsequential);
+		uint8_t swapVal = m_bus.read8<debug>(swapAddress,AccessType::Nonsequential);
+		m_bus.write8<debug>(swapAddress, srcData & 0xFF, AccessType::Nonsequential);
 		setReg(destRegIdx, swapVal);
 		
 	}
 
 	else				//swap word
 	{
-		uint32_t swapVal = m_bus->read32(swapAddress, AccessType::Nonsequential);
+		uint32_t swapVal = m_bus.read32<debug>(swapAddress, AccessType::Nonsequential);
 		if (swapAddress & 3)
 			swapVal = std::rotr(swapVal, (swapAddress & 3) * 8);
-		m_bus->write32(swapAddress, srcData, AccessType::Nonsequential);
+		m_bus.write32<debug>(swapAddress, srcData, AccessType::Nonsequential);
 		setReg(destRegIdx, swapVal);
 	}
-	m_scheduler->addCycles(4);
-	m_bus->tickPrefetcher(1);
+	m_scheduler.addCycles(4);
+	m_bus.tickPrefetcher(1);
 	nextFetchNonsequential = true;
-	m_bus->setBusLocked(false);
+	m_bus.setBusLocked(false);
 }
 
 
@@ -419,10 +419,10 @@ void ARM7TDMI::ARM_BranchExchange()
 	{
 		setReg(15, newAddr & ~0b11);
 	}
-	m_scheduler->addCycles(3);
+	m_scheduler.addCycles(3);
 }
 
-void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
+template<bool debug> void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 {
 	bool prePost = ((m_currentOpcode >> 24) & 0b1);
 	bool upDown = ((m_currentOpcode >> 23) & 0b1);
@@ -447,7 +447,7 @@ void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 	if (loadStore)
 	{
 		if (srcDestRegIdx == 15)
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		uint32_t val = 0;
 		switch (operation)
 		{
@@ -455,13 +455,13 @@ void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 			Logger::getInstance()->msg(LoggerSeverity::Error, "SWP called from halfword transfer - opcode decoding is invalid!!!");
 			break;
 		case 1:
-			val = m_bus->read16(base, AccessType::Nonsequential);
+			val = m_bus.read16<debug>(base, AccessType::Nonsequential);
 			if (base & 1)
 				val = std::rotr(val, 8);
 			setReg(srcDestRegIdx, val);
 			break;
 		case 2:
-			val = m_bus->read8(base, AccessType::Nonsequential);
+			val = m_bus.read8<debug>(base, AccessType::Nonsequential);
 			if (((val >> 7) & 0b1))
 				val |= 0xFFFFFF00;
 			setReg(srcDestRegIdx, val);
@@ -469,21 +469,21 @@ void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 		case 3:
 			if (!(base & 0b1))
 			{
-				val = m_bus->read16(base, AccessType::Nonsequential);
+				val = m_bus.read16<debug>(base, AccessType::Nonsequential);
 				if (((val >> 15) & 0b1))
 					val |= 0xFFFF0000;
 			}
 			else
 			{
-				val = m_bus->read8(base, AccessType::Nonsequential);
+				val = m_bus.read8<debug>(base, AccessType::Nonsequential);
 				if (((val >> 7) & 0b1))
 					val |= 0xFFFFFF00;
 			}
 			setReg(srcDestRegIdx, val);
 			break;
 		}
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else						//store
 	{
@@ -496,16 +496,16 @@ void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 			Logger::getInstance()->msg(LoggerSeverity::Error, "Invalid halfword operation encoding");
 			break;
 		case 1:
-			m_bus->write16(base, data & 0xFFFF, AccessType::Nonsequential);
+			m_bus.write16<debug>(base, data & 0xFFFF, AccessType::Nonsequential);
 			break;
 		case 2:
-			m_bus->write8(base, data & 0xFF, AccessType::Nonsequential);
+			m_bus.write8<debug>(base, data & 0xFF, AccessType::Nonsequential);
 			break;
 		case 3:
-			m_bus->write16(base, data & 0xFFFF, AccessType::Nonsequential);
+			m_bus.write16<debug>(base, data & 0xFFFF, AccessType::Nonsequential);
 			break;
 		}
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 	}
 
 	if (!prePost)
@@ -522,7 +522,7 @@ void ARM7TDMI::ARM_HalfwordTransferRegisterOffset()
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
+template<bool debug> void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 {
 	bool prePost = ((m_currentOpcode >> 24) & 0b1);
 	bool upDown = ((m_currentOpcode >> 23) & 0b1);
@@ -549,7 +549,7 @@ void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 	if (loadStore)				//load
 	{
 		if (srcDestRegIdx == 15)
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		uint32_t data = 0;
 		switch (op)
 		{
@@ -557,13 +557,13 @@ void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 			Logger::getInstance()->msg(LoggerSeverity::Error, "Invalid halfword operation encoding");
 			break;
 		case 1:
-			data = m_bus->read16(base, AccessType::Nonsequential);
+			data = m_bus.read16<debug>(base, AccessType::Nonsequential);
 			if (base & 1)
 				data = std::rotr(data, 8);
 			setReg(srcDestRegIdx, data);
 			break;
 		case 2:
-			data = m_bus->read8(base, AccessType::Nonsequential);
+			data = m_bus.read8<debug>(base, AccessType::Nonsequential);
 			if (((data >> 7) & 0b1))	//sign extend byte if bit 7 set
 				data |= 0xFFFFFF00;
 			setReg(srcDestRegIdx, data);
@@ -571,21 +571,21 @@ void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 		case 3:
 			if (!(base & 0b1))
 			{
-				data = m_bus->read16(base, AccessType::Nonsequential);
+				data = m_bus.read16<debug>(base, AccessType::Nonsequential);
 				if (((data >> 15) & 0b1))
 					data |= 0xFFFF0000;
 			}
 			else
 			{
-				data = m_bus->read8(base, AccessType::Nonsequential);
+				data = m_bus.read8<debug>(base, AccessType::Nonsequential);
 				if (((data >> 7) & 0b1))
 					data |= 0xFFFFFF00;
 			}
 			setReg(srcDestRegIdx, data);
 			break;
 		}
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else						//store
 	{
@@ -598,16 +598,16 @@ void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 			Logger::getInstance()->msg(LoggerSeverity::Error, "Invalid halfword operation encoding");
 			break;
 		case 1:
-			m_bus->write16(base, data & 0xFFFF, AccessType::Nonsequential);
+			m_bus.write16<debug>(base, data & 0xFFFF, AccessType::Nonsequential);
 			break;
 		case 2:
-			m_bus->write8(base, data & 0xFF, AccessType::Nonsequential);
+			m_bus.write8<debug>(base, data & 0xFF, AccessType::Nonsequential);
 			break;
 		case 3:
-			m_bus->write16(base, data & 0xFFFF, AccessType::Nonsequential);
+			m_bus.write16<debug>(base, data & 0xFFFF, AccessType::Nonsequential);
 			break;
 		}
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 	}
 
 	if (!prePost)
@@ -624,7 +624,7 @@ void ARM7TDMI::ARM_HalfwordTransferImmediateOffset()
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::ARM_SingleDataTransfer()
+template<bool debug> void ARM7TDMI::ARM_SingleDataTransfer()
 {
 	bool immediate = ((m_currentOpcode >> 25) & 0b1);
 	bool preIndex = ((m_currentOpcode >> 24) & 0b1);
@@ -677,21 +677,21 @@ void ARM7TDMI::ARM_SingleDataTransfer()
 	if (loadStore) //load value
 	{
 		if (destRegIdx == 15)
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		uint32_t val = 0;
 		if (byteWord)
 		{
-			val = m_bus->read8(base, AccessType::Nonsequential);
+			val = m_bus.read8<debug>(base, AccessType::Nonsequential);
 		}
 		else
 		{
-			val = m_bus->read32(base, AccessType::Nonsequential);
+			val = m_bus.read32<debug>(base, AccessType::Nonsequential);
 			if(base&3)
 				val = std::rotr(val, (base & 3) * 8);
 		}
 		setReg(destRegIdx, val);
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else //store value
 	{
@@ -700,13 +700,13 @@ void ARM7TDMI::ARM_SingleDataTransfer()
 			val += 4;
 		if (byteWord)
 		{
-			m_bus->write8(base, val & 0xFF, AccessType::Nonsequential);
+			m_bus.write8<debug>(base, val & 0xFF, AccessType::Nonsequential);
 		}
 		else
 		{
-			m_bus->write32(base, val, AccessType::Nonsequential);
+			m_bus.write32<debug>(base, val, AccessType::Nonsequential);
 		}
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 	}
 
 	if (!preIndex)
@@ -726,7 +726,7 @@ void ARM7TDMI::ARM_Undefined()
 	throw std::runtime_error("unimplemented");
 }
 
-void ARM7TDMI::ARM_BlockDataTransfer()
+template<bool debug> void ARM7TDMI::ARM_BlockDataTransfer()
 {
 	bool prePost = ((m_currentOpcode >> 24) & 0b1);
 	bool upDown = ((m_currentOpcode >> 23) & 0b1);
@@ -772,7 +772,7 @@ void ARM7TDMI::ARM_BlockDataTransfer()
 
 			uint32_t val = 0;
 			if (loadStore)
-				val = m_bus->read32(base_addr, (AccessType)!firstTransfer);
+				val = m_bus.read32<debug>(base_addr, (AccessType)!firstTransfer);
 			else
 			{
 				val = getReg(i);
@@ -797,7 +797,7 @@ void ARM7TDMI::ARM_BlockDataTransfer()
 			if (loadStore)
 				setReg(i, val);
 			else
-				m_bus->write32(base_addr, val, (AccessType)!firstTransfer);
+				m_bus.write32<debug>(base_addr, val, (AccessType)!firstTransfer);
 
 			firstTransfer = false;
 
@@ -810,9 +810,9 @@ void ARM7TDMI::ARM_BlockDataTransfer()
 		setReg(baseReg, finalBase);	//don't use base_addr, because decrementing load/stores will modify the internal transfer register differently
 
 	int cycles = transferCount + ((loadStore) ? 2 : 1);
-	m_scheduler->addCycles(cycles);
+	m_scheduler.addCycles(cycles);
 	if (loadStore)
-		m_bus->tickPrefetcher(1);
+		m_bus.tickPrefetcher(1);
 
 	if (transferCount == 0)		//no registers to transfer, weird behaviour
 	{
@@ -828,19 +828,19 @@ void ARM7TDMI::ARM_BlockDataTransfer()
 
 		if (loadStore)
 		{
-			setReg(15, m_bus->read32(base_addr, AccessType::Nonsequential));
-			m_scheduler->addCycles(2);
+			setReg(15, m_bus.read32<debug>(base_addr, AccessType::Nonsequential));
+			m_scheduler.addCycles(2);
 		}
 		else
 		{
-			m_bus->write32(base_addr, getReg(15) + 4, AccessType::Nonsequential);
-			m_scheduler->addCycles(1);
+			m_bus.write32<debug>(base_addr, getReg(15) + 4, AccessType::Nonsequential);
+			m_scheduler.addCycles(1);
 		}
 
 		if (upDown)
 			setReg(baseReg, old_base + 0x40);	//use old_base bc 'base_addr' might have been offset by 4h already
 
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 	}
 
 	nextFetchNonsequential = true;
@@ -884,5 +884,17 @@ void ARM7TDMI::ARM_SoftwareInterrupt()
 	setSPSR(oldCPSR);			//set SPSR_svc
 	setReg(14, oldPC);			//Save old R15
 	setReg(15, 0x00000008);		//SWI entry point is 0x08
-	m_scheduler->addCycles(3);
-}
\ No newline at end of file
+	m_scheduler.addCycles(3);
+}
+
+//load/store handlers exist for both run loops - the debug ones check data watchpoints
+template void ARM7TDMI::ARM_SingleDataSwap<false>();
+template void ARM7TDMI::ARM_SingleDataSwap<true>();
+template void ARM7TDMI::ARM_HalfwordTransferRegisterOffset<false>();
+template void ARM7TDMI::ARM_HalfwordTransferRegisterOffset<true>();
+template void ARM7TDMI::ARM_HalfwordTransferImmediateOffset<false>();
+template void ARM7TDMI::ARM_HalfwordTransferImmediateOffset<true>();
+template void ARM7TDMI::ARM_SingleDataTransfer<false>();
+template void ARM7TDMI::ARM_SingleDataTransfer<true>();
+template void ARM7TDMI::ARM_BlockDataTransfer<false>();
+template void ARM7TDMI::ARM_BlockDataTransfer<true>();
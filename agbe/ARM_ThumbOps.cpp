@@ -21,7 +21,7 @@ void ARM7TDMI::Thumb_MoveShiftedRegister()
 
 	setLogicalFlags(result, carry);
 	R[destRegIdx] = result;
-	m_scheduler->addCycles(1);	//not sure, but it is an 'alu op'
+	m_scheduler.addCycles(1);	//not sure, but it is an 'alu op'
 }
 
 void ARM7TDMI::Thumb_AddSubtract()
@@ -56,7 +56,7 @@ void ARM7TDMI::Thumb_AddSubtract()
 		setArithmeticFlags(operand1, operand2, result, false);
 		break;
 	}
-	m_scheduler->addCycles(1);
+	m_scheduler.addCycles(1);
 }
 
 void ARM7TDMI::Thumb_MoveCompareAddSubtractImm()
@@ -90,7 +90,7 @@ void ARM7TDMI::Thumb_MoveCompareAddSubtractImm()
 		setArithmeticFlags(operand1, offset, result, false);
 		break;
 	}
-	m_scheduler->addCycles(1);	//not sure :P
+	m_scheduler.addCycles(1);	//not sure :P
 }
 
 void ARM7TDMI::Thumb_ALUOperations()
@@ -188,8 +188,8 @@ void ARM7TDMI::Thumb_ALUOperations()
 		result = operand1 * operand2;
 		R[srcDestRegIdx] = result;
 		setLogicalFlags(result, -1);	//hmm...
-		m_scheduler->addCycles(calculateMultiplyCycles(operand1, true));
-		m_bus->tickPrefetcher(calculateMultiplyCycles(operand1, true));
+		m_scheduler.addCycles(calculateMultiplyCycles(operand1, true));
+		m_bus.tickPrefetcher(calculateMultiplyCycles(operand1, true));
 		nextFetchNonsequential = true;	//mul has internal cycles, so next fetch is forced nonsequential for some reason.
 		break;
 	case 14: //BIC
@@ -203,7 +203,7 @@ void ARM7TDMI::Thumb_ALUOperations()
 		setLogicalFlags(result, -1);
 		break;
 	}
-	m_scheduler->addCycles(1);
+	m_scheduler.addCycles(1);
 }
 
 void ARM7TDMI::Thumb_HiRegisterOperations()
@@ -229,7 +229,7 @@ void ARM7TDMI::Thumb_HiRegisterOperations()
 		if (dstRegIdx == 15)
 		{
 			setReg(dstRegIdx, result & ~0b1);
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		}
 		break;
 	case 1:
@@ -242,7 +242,7 @@ void ARM7TDMI::Thumb_HiRegisterOperations()
 		if (dstRegIdx == 15)
 		{
 			setReg(dstRegIdx, result & ~0b1);
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		}
 		break;
 	case 3:
@@ -253,35 +253,35 @@ void ARM7TDMI::Thumb_HiRegisterOperations()
 			m_inThumbMode = false;
 			operand2 &= ~0b11;
 			setReg(15, operand2);
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		}
 		else
 		{
 			//stay in thumb
 			operand2 &= ~0b1;
 			setReg(15, operand2);
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		}
 		break;
 	}
-	m_scheduler->addCycles(1);
+	m_scheduler.addCycles(1);
 }
 
-void ARM7TDMI::Thumb_PCRelativeLoad()
+template<bool debug> void ARM7TDMI::Thumb_PCRelativeLoad()
 {
 	uint32_t offset = (m_currentOpcode & 0xFF) << 2;
 	uint32_t PC = R[15] & ~0b11;	//PC is force aligned to word boundary
 
 	uint8_t destRegIdx = ((m_currentOpcode >> 8) & 0b111);
 
-	uint32_t val = m_bus->read32(PC + offset, AccessType::Nonsequential);
+	uint32_t val = m_bus.read32<debug>(PC + offset, AccessType::Nonsequential);
 	R[destRegIdx] = val;
-	m_scheduler->addCycles(3);	//probs right? 
-	m_bus->tickPrefetcher(1);
+	m_scheduler.addCycles(3);	//probs right? 
+	m_bus.tickPrefetcher(1);
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_LoadStoreRegisterOffset()
+template<bool debug> void ARM7TDMI::Thumb_LoadStoreRegisterOffset()
 {
 	bool loadStore = ((m_currentOpcode >> 11) & 0b1);
 	bool byteWord = ((m_currentOpcode >> 10) & 0b1);
@@ -296,37 +296,37 @@ void ARM7TDMI::Thumb_LoadStoreRegisterOffset()
 	{
 		if (byteWord)
 		{
-			uint32_t val = m_bus->read8(base, AccessType::Nonsequential);
+			uint32_t val = m_bus.read8<debug>(base, AccessType::Nonsequential);
 			R[srcDestRegIdx] = val;
 		}
 		else
 		{
-			uint32_t val = m_bus->read32(base, AccessType::Nonsequential);
+			uint32_t val = m_bus.read32<debug>(base, AccessType::Nonsequential);
 			if (base & 3)
 				val = std::rotr(val, (base & 3) * 8);
 			R[srcDestRegIdx] = val;
 		}
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else			//store
 	{
 		if (byteWord)
 		{
 			uint8_t val = R[srcDestRegIdx] & 0xFF;
-			m_bus->write8(base, val, AccessType::Nonsequential);
+			m_bus.write8<debug>(base, val, AccessType::Nonsequential);
 		}
 		else
 		{
 			uint32_t val = R[srcDestRegIdx];
-			m_bus->write32(base, val, AccessType::Nonsequential);
+			m_bus.write32<debug>(base, val, AccessType::Nonsequential);
 		}
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 	}
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_LoadStoreSignExtended()
+template<bool debug> void ARM7TDMI::Thumb_LoadStoreSignExtended()
 {
 	uint8_t op = ((m_currentOpcode >> 10) & 0b11);
 	uint8_t offsetRegIdx = ((m_currentOpcode >> 6) & 0b111);
@@ -339,50 +339,50 @@ void ARM7TDMI::Thumb_LoadStoreSignExtended()
 	if (op == 0)
 	{
 		uint16_t val = R[srcDestRegIdx] &0xFFFF;
-		m_bus->write16(addr, val, AccessType::Nonsequential);
-		m_scheduler->addCycles(2);
+		m_bus.write16<debug>(addr, val, AccessType::Nonsequential);
+		m_scheduler.addCycles(2);
 	}
 	else if (op == 2)	//load halfword
 	{
-		uint32_t val = m_bus->read16(addr, AccessType::Nonsequential);
+		uint32_t val = m_bus.read16<debug>(addr, AccessType::Nonsequential);
 		if (addr & 0b1)
 			val = std::rotr(val, 8);
 		R[srcDestRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else if (op == 1)	//load sign extended byte
 	{
-		uint32_t val = m_bus->read8(addr, AccessType::Nonsequential);
+		uint32_t val = m_bus.read8<debug>(addr, AccessType::Nonsequential);
 		if (((val >> 7) & 0b1))
 			val |= 0xFFFFFF00;
 		R[srcDestRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else if (op == 3)   //load sign extended halfword
 	{
 		uint32_t val = 0;
 		if (!(addr & 0b1))
 		{
-			val = m_bus->read16(addr, AccessType::Nonsequential);
+			val = m_bus.read16<debug>(addr, AccessType::Nonsequential);
 			if (((val >> 15) & 0b1))
 				val |= 0xFFFF0000;
 		}
 		else
 		{
-			val = m_bus->read8(addr, AccessType::Nonsequential);
+			val = m_bus.read8<debug>(addr, AccessType::Nonsequential);
 			if (((val >> 7) & 0b1))
 				val |= 0xFFFFFF00;
 		}
 		R[srcDestRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_LoadStoreImmediateOffset()
+template<bool debug> void ARM7TDMI::Thumb_LoadStoreImmediateOffset()
 {
 	bool byteWord = ((m_currentOpcode >> 12) & 0b1);
 	bool loadStore = ((m_currentOpcode >> 11) & 0b1);
@@ -399,31 +399,31 @@ void ARM7TDMI::Thumb_LoadStoreImmediateOffset()
 	{
 		uint32_t val = 0;
 		if (byteWord)
-			val = m_bus->read8(baseAddr, AccessType::Nonsequential);
+			val = m_bus.read8<debug>(baseAddr, AccessType::Nonsequential);
 		else
 		{
-			val = m_bus->read32(baseAddr, AccessType::Nonsequential);
+			val = m_bus.read32<debug>(baseAddr, AccessType::Nonsequential);
 			if (baseAddr & 3)
 				val = std::rotr(val, (baseAddr & 3) * 8);
 		}
 		R[srcDestRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else			//Store value to memory
 	{
 		uint32_t val = R[srcDestRegIdx];
 		if (byteWord)
-			m_bus->write8(baseAddr, val & 0xFF, AccessType::Nonsequential);
+			m_bus.write8<debug>(baseAddr, val & 0xFF, AccessType::Nonsequential);
 		else
-			m_bus->write32(baseAddr, val, AccessType::Nonsequential);
-		m_scheduler->addCycles(2);
+			m_bus.write32<debug>(baseAddr, val, AccessType::Nonsequential);
+		m_scheduler.addCycles(2);
 	}
 
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_LoadStoreHalfword()
+template<bool debug> void ARM7TDMI::Thumb_LoadStoreHalfword()
 {
 	bool loadStore = ((m_currentOpcode >> 11) & 0b1);
 	uint32_t offset = ((m_currentOpcode >> 6) & 0x1F);
@@ -437,23 +437,23 @@ void ARM7TDMI::Thumb_LoadStoreHalfword()
 
 	if (loadStore)
 	{
-		uint32_t val = m_bus->read16(base, AccessType::Nonsequential);
+		uint32_t val = m_bus.read16<debug>(base, AccessType::Nonsequential);
 		if (base & 0b1)
 			val = std::rotr(val, 8);
 		R[srcDestRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else
 	{
 		uint16_t val = R[srcDestRegIdx] &0xFFFF;
-		m_bus->write16(base, val, AccessType::Nonsequential);
-		m_scheduler->addCycles(2);
+		m_bus.write16<debug>(base, val, AccessType::Nonsequential);
+		m_scheduler.addCycles(2);
 	}
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_SPRelativeLoadStore()
+template<bool debug> void ARM7TDMI::Thumb_SPRelativeLoadStore()
 {
 	bool loadStore = ((m_currentOpcode >> 11) & 0b1);
 	uint8_t destRegIdx = ((m_currentOpcode >> 8) & 0b111);
@@ -464,18 +464,18 @@ void ARM7TDMI::Thumb_SPRelativeLoadStore()
 
 	if (loadStore)
 	{
-		uint32_t val = m_bus->read32(addr, AccessType::Nonsequential);
+		uint32_t val = m_bus.read32<debug>(addr, AccessType::Nonsequential);
 		if (addr & 3)
 			val = std::rotr(val, (addr & 3) * 8);
 		R[destRegIdx] = val;
-		m_scheduler->addCycles(3);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(3);
+		m_bus.tickPrefetcher(1);
 	}
 	else
 	{
 		uint32_t val = R[destRegIdx];
-		m_bus->write32(addr, val, AccessType::Nonsequential);
-		m_scheduler->addCycles(2);
+		m_bus.write32<debug>(addr, val, AccessType::Nonsequential);
+		m_scheduler.addCycles(2);
 	}
 	nextFetchNonsequential = true;
 }
@@ -500,7 +500,7 @@ void ARM7TDMI::Thumb_LoadAddress()
 		PC += offset;
 		R[destRegIdx] = PC;
 	}
-	m_scheduler->addCycles(1);	//probs right?
+	m_scheduler.addCycles(1);	//probs right?
 }
 
 void ARM7TDMI::Thumb_AddOffsetToStackPointer()
@@ -514,10 +514,10 @@ void ARM7TDMI::Thumb_AddOffsetToStackPointer()
 		SP += offset;
 
 	setReg(13, SP);
-	m_scheduler->addCycles(1);	//probs right?
+	m_scheduler.addCycles(1);	//probs right?
 }
 
-void ARM7TDMI::Thumb_PushPopRegisters()
+template<bool debug> void ARM7TDMI::Thumb_PushPopRegisters()
 {
 	bool loadStore = ((m_currentOpcode >> 11) & 0b1);
 	bool PCLR = ((m_currentOpcode >> 8) & 0b1);	//couldnt think of good abbreviation :/
@@ -535,7 +535,7 @@ void ARM7TDMI::Thumb_PushPopRegisters()
 			if (((regs >> i) & 0b1))
 			{
 				transferCount++;
-				uint32_t popVal = m_bus->read32(SP,(AccessType)!firstTransfer);
+				uint32_t popVal = m_bus.read32<debug>(SP,(AccessType)!firstTransfer);
 				R[i] = popVal;
 				SP += 4;
 				firstTransfer = false;
@@ -544,13 +544,13 @@ void ARM7TDMI::Thumb_PushPopRegisters()
 
 		if (PCLR)
 		{
-			uint32_t newPC = m_bus->read32(SP,(AccessType)!firstTransfer);
+			uint32_t newPC = m_bus.read32<debug>(SP,(AccessType)!firstTransfer);
 			setReg(15, newPC & ~0b1);
 			SP += 4;
-			m_scheduler->addCycles(2);
+			m_scheduler.addCycles(2);
 		}
-		m_scheduler->addCycles(transferCount + 2);
-		m_bus->tickPrefetcher(1);
+		m_scheduler.addCycles(transferCount + 2);
+		m_bus.tickPrefetcher(1);
 
 	}
 	else          //Store - i.e. push to stack
@@ -559,9 +559,9 @@ void ARM7TDMI::Thumb_PushPopRegisters()
 		if (PCLR)
 		{
 			SP -= 4;
-			m_bus->write32(SP, getReg(14), AccessType::Nonsequential);
+			m_bus.write32<debug>(SP, getReg(14), AccessType::Nonsequential);
 			firstTransfer = false;
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		}
 
 		for (int i = 7; i >= 0; i--)
@@ -570,19 +570,19 @@ void ARM7TDMI::Thumb_PushPopRegisters()
 			{
 				transferCount++;
 				SP -= 4;
-				m_bus->write32(SP, R[i], (AccessType)!firstTransfer);
+				m_bus.write32<debug>(SP, R[i], (AccessType)!firstTransfer);
 				firstTransfer = false;
 			}
 		}
 
-		m_scheduler->addCycles(transferCount + 1);
+		m_scheduler.addCycles(transferCount + 1);
 	}
 
 	setReg(13, SP);
 	nextFetchNonsequential = true;
 }
 
-void ARM7TDMI::Thumb_MultipleLoadStore()
+template<bool debug> void ARM7TDMI::Thumb_MultipleLoadStore()
 {
 	bool loadStore = (m_currentOpcode >> 11) & 0b1;
 	uint8_t baseRegIdx = ((m_currentOpcode >> 8) & 0b111);
@@ -603,7 +603,7 @@ void ARM7TDMI::Thumb_MultipleLoadStore()
 		{
 			if (loadStore)
 			{
-				uint32_t val = m_bus->read32(base, (AccessType)!firstAccess);
+				uint32_t val = m_bus.read32<debug>(base, (AccessType)!firstAccess);
 				R[i] = val;
 				if (i == baseRegIdx)		//load with base included -> no writeback
 					writeback = false;
@@ -614,7 +614,7 @@ void ARM7TDMI::Thumb_MultipleLoadStore()
 				uint32_t val = R[i];
 				if (i == baseRegIdx && !baseIsFirst)
 					val = finalBase;
-				m_bus->write32(base, val, (AccessType)!firstAccess);
+				m_bus.write32<debug>(base, val, (AccessType)!firstAccess);
 			}
 			firstAccess = false;
 			base += 4;
@@ -624,23 +624,23 @@ void ARM7TDMI::Thumb_MultipleLoadStore()
 	if (transferCount)
 	{
 		int totalCycles = transferCount + ((loadStore) ? 2 : 1);
-		m_scheduler->addCycles(totalCycles);
+		m_scheduler.addCycles(totalCycles);
 		if (loadStore)
-			m_bus->tickPrefetcher(1);
+			m_bus.tickPrefetcher(1);
 	}
 	else
 	{
 		if (loadStore)
 		{
 			//not sure about this timing.
-			setReg(15, m_bus->read32(base, AccessType::Nonsequential));
-			m_scheduler->addCycles(3);
-			m_bus->tickPrefetcher(1);
+			setReg(15, m_bus.read32<debug>(base, AccessType::Nonsequential));
+			m_scheduler.addCycles(3);
+			m_bus.tickPrefetcher(1);
 		}
 		else
 		{
-			m_bus->write32(base, R[15] + 2, AccessType::Nonsequential);	//+2 for pipeline effect
-			m_scheduler->addCycles(2);
+			m_bus.write32<debug>(base, R[15] + 2, AccessType::Nonsequential);	//+2 for pipeline effect
+			m_scheduler.addCycles(2);
 		}
 		R[baseRegIdx] = base + 0x40;
 		writeback = false;
@@ -665,12 +665,12 @@ void ARM7TDMI::Thumb_ConditionalBranch()
 	bool conditionMet = (conditionTable[(CPSR >> 28) & 0xF] >> condition) & 0b1;
 	if (!conditionMet)
 	{
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		return;
 	}
 
 	setReg(15, R[15] + offset);
-	m_scheduler->addCycles(3);
+	m_scheduler.addCycles(3);
 }
 
 void ARM7TDMI::Thumb_SoftwareInterrupt()
@@ -690,7 +690,7 @@ void ARM7TDMI::Thumb_SoftwareInterrupt()
 	setSPSR(oldCPSR);			//set SPSR_svc
 	setReg(14, oldPC);			//Save old R15
 	setReg(15, 0x00000008);		//SWI entry point is 0x08
-	m_scheduler->addCycles(3);
+	m_scheduler.addCycles(3);
 }
 
 void ARM7TDMI::Thumb_UnconditionalBranch()
@@ -701,7 +701,7 @@ void ARM7TDMI::Thumb_UnconditionalBranch()
 		offset |= 0xFFFFF000;
 
 	setReg(15, R[15] + offset);
-	m_scheduler->addCycles(3);
+	m_scheduler.addCycles(3);
 }
 
 void ARM7TDMI::Thumb_LongBranchWithLink()
@@ -714,7 +714,7 @@ void ARM7TDMI::Thumb_LongBranchWithLink()
 		if (offset & 0x400000) { offset |= 0xFF800000; }
 		uint32_t res = R[15] + offset;
 		setReg(14, res & ~0b1);
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 	}
 	else			//H=1: leftshift by 1 and add to LR - then copy LR to PC. copy old PC (-2) to LR and set bit 0
 	{
@@ -723,6 +723,24 @@ void ARM7TDMI::Thumb_LongBranchWithLink()
 		LR += offset;
 		setReg(14, ((R[15] - 2) | 0b1));	//set LR to point to instruction after this one
 		setReg(15, LR);				//set PC to old LR contents (plus the offset)
-		m_scheduler->addCycles(3);
+		m_scheduler.addCycles(3);
 	}
-}
\ No newline at end of file
+}
+
+//load/store handlers exist for both run loops - the debug ones check data watchpoints
+template void ARM7TDMI::Thumb_PCRelativeLoad<false>();
+template void ARM7TDMI::Thumb_PCRelativeLoad<true>();
+template void ARM7TDMI::Thumb_LoadStoreRegisterOffset<false>();
+template void ARM7TDMI::Thumb_LoadStoreRegisterOffset<true>();
+template void ARM7TDMI::Thumb_LoadStoreSignExtended<false>();
+template void ARM7TDMI::Thumb_LoadStoreSignExtended<true>();
+template void ARM7TDMI::Thumb_LoadStoreImmediateOffset<false>();
+template void ARM7TDMI::Thumb_LoadStoreImmediateOffset<true>();
+template void ARM7TDMI::Thumb_LoadStoreHalfword<false>();
+template void ARM7TDMI::Thumb_LoadStoreHalfword<true>();
+template void ARM7TDMI::Thumb_SPRelativeLoadStore<false>();
+template void ARM7TDMI::Thumb_SPRelativeLoadStore<true>();
+template void ARM7TDMI::Thumb_PushPopRegisters<false>();
+template void ARM7TDMI::Thumb_PushPopRegisters<true>();
+template void ARM7TDMI::Thumb_MultipleLoadStore<false>();
+template void ARM7TDMI::Thumb_MultipleLoadStore<true>();
@@ -0,0 +1,109 @@
+#include"AudioResampler.h"
+
+#include<cmath>
+#include<algorithm>
+
+AudioResampler::AudioResampler(int inputRate, int outputRate) : m_inputRate(inputRate)
+{
+	buildKernel(outputRate);
+	m_historyL.resize(numTaps);
+	m_historyR.resize(numTaps);
+	m_buffered = numTaps - 1;		//start off with silence behind the first sample
+	Logger::getInstance()->msg(LoggerSeverity::Info, std::format("Resampling audio {}Hz -> {}Hz", inputRate, outputRate));
+}
+
+AudioResampler::~AudioResampler()
+{
+
+}
+
+void AudioResampler::setOutputRate(int outputRate)
+{
+	buildKernel(outputRate);
+}
+
+void AudioResampler::buildKernel(int outputRate)
+{
+	int inputRate = m_inputRate;
+	//an output can't skip more input than its taps span, otherwise process() steps past what's buffered
+	outputRate = (std::max)(outputRate, (inputRate + numTaps - 1) / numTaps);
+	m_step = ((uint64_t)inputRate << 32) / outputRate;
+
+	//cutoff a bit under whichever nyquist is lower, in cycles per input sample
+	double ratio = (outputRate < inputRate) ? ((double)outputRate / (double)inputRate) : 1.0;
+	double cutoff = 0.5 * ratio * 0.9;
+	static constexpr double pi = 3.14159265358979323846;
+	for (int phase = 0; phase < numPhases; phase++)
+	{
+		double fraction = (double)phase / numPhases;
+		double sum = 0;
+		for (int k = 0; k < numTaps; k++)
+		{
+			double x = ((numTaps / 2) - 1) + fraction - k;		//distance from the output's position to this tap
+			double sinc = (x == 0) ? 1.0 : std::sin(2 * pi * cutoff * x) / (2 * pi * cutoff * x);
+			double windowPos = (x / numTaps) + 0.5;					//blackman window over the taps
+			double window = 0.42 - 0.5 * std::cos(2 * pi * windowPos) + 0.08 * std::cos(4 * pi * windowPos);
+			double weight = sinc * ((windowPos < 0 || windowPos > 1) ? 0.0 : window);
+			m_kernel[phase][k] = (float)weight;
+			sum += weight;
+		}
+		for (int k = 0; k < numTaps; k++)		//unity gain at dc for every phase
+			m_kernel[phase][k] = (float)(m_kernel[phase][k] / sum);
+	}
+}
+
+uint32_t AudioResampler::getMaxOutputFrames(uint32_t inputFrames)
+{
+	return (uint32_t)((((uint64_t)(inputFrames + numTaps) << 32) / m_step) + 1);
+}
+
+uint32_t AudioResampler::process(const float* in, uint32_t inputFrames, float* out)
+{
+	if (m_historyL.size() < m_buffered + inputFrames)
+	{
+		m_historyL.resize(m_buffered + inputFrames);
+		m_historyR.resize(m_buffered + inputFrames);
+	}
+	for (uint32_t i = 0; i < inputFrames; i++)
+	{
+		m_historyL[m_buffered + i] = in[i * 2];
+		m_historyR[m_buffered + i] = in[(i * 2) + 1];
+	}
+	m_buffered += inputFrames;
+
+	uint32_t outputFrames = 0;
+	const float* historyL = m_historyL.data();
+	const float* historyR = m_historyR.data();
+	while ((uint32_t)(m_position >> 32) + numTaps <= m_buffered)
+	{
+		uint32_t base = (uint32_t)(m_position >> 32);
+		const float* kernel = m_kernel[(m_position >> 24) & (numPhases - 1)];
+		__m128 sumL = _mm_setzero_ps();
+		__m128 sumR = _mm_setzero_ps();
+		for (int k = 0; k < numTaps; k += 4)
+		{
+			__m128 weights = _mm_load_ps(&kernel[k]);
+			sumL = _mm_add_ps(sumL, _mm_mul_ps(weights, _mm_loadu_ps(&historyL[base + k])));
+			sumR = _mm_add_ps(sumR, _mm_mul_ps(weights, _mm_loadu_ps(&historyR[base + k])));
+		}
+
+		//horizontal add: lanes 0+2, 1+3 for both, then the last pair
+		__m128 lo = _mm_unpacklo_ps(sumL, sumR);		//L0 R0 L1 R1
+		__m128 hi = _mm_unpackhi_ps(sumL, sumR);		//L2 R2 L3 R3
+		__m128 pairs = _mm_add_ps(lo, hi);
+		__m128 result = _mm_add_ps(pairs, _mm_movehl_ps(pairs, pairs));
+		_mm_storel_pi((__m64*)&out[outputFrames * 2], result);
+
+		outputFrames++;
+		m_position += m_step;
+	}
+
+	//drop the input that no future output needs. if the next output starts past everything buffered, the rest of the skip carries over in m_position
+	uint32_t consumed = (uint32_t)(std::min)(m_position >> 32, (uint64_t)m_buffered);
+	uint32_t remaining = m_buffered - consumed;
+	memmove(m_historyL.data(), m_historyL.data() + consumed, remaining * sizeof(float));
+	memmove(m_historyR.data(), m_historyR.data() + consumed, remaining * sizeof(float));
+	m_buffered = remaining;
+	m_position -= ((uint64_t)consumed << 32);
+	return outputFrames;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include"Logger.h"
+
+#include<vector>
+#include<immintrin.h>
+
+//polyphase windowed-sinc resampler, from the apu's mixing rate to whatever rate the host wants. it's also what band-limits the
+//output, so nothing above the output's nyquist folds back down into the audible range
+class AudioResampler
+{
+public:
+	AudioResampler(int inputRate, int outputRate);
+	~AudioResampler();
+
+	void setOutputRate(int outputRate);		//keeps the input history, so output carries on without a gap. clamped to at least inputRate/numTaps
+
+	uint32_t getMaxOutputFrames(uint32_t inputFrames);
+	uint32_t process(const float* in, uint32_t inputFrames, float* out);	//interleaved L/R in and out. returns frames written
+private:
+	static constexpr int numTaps = 48;			//per phase - keep it a multiple of 4
+	static constexpr int numPhases = 256;
+
+	int m_inputRate = 0;
+	void buildKernel(int outputRate);
+
+	alignas(16) float m_kernel[numPhases][numTaps] = {};
+	std::vector<float> m_historyL;				//planar, so each output's taps are contiguous
+	std::vector<float> m_historyR;
+	uint32_t m_buffered = 0;
+	uint64_t m_position = 0;					//32.32 fixed point, index of the first tap for the next output
+	uint64_t m_step = 0;
+};
@@ -0,0 +1,80 @@
+#include"AudioRing.h"
+
+AudioRing::AudioRing(uint32_t capacityFrames) : m_capacity(capacityFrames)
+{
+	m_samples = std::make_unique<float[]>(m_capacity * 2);
+}
+
+AudioRing::~AudioRing()
+{
+
+}
+
+void AudioRing::push(const float* frames, uint32_t count)
+{
+	uint32_t writePos = m_writePos.load(std::memory_order_relaxed);
+	if ((m_capacity - (writePos - m_cachedReadPos)) < count)
+		m_cachedReadPos = m_readPos.load(std::memory_order_acquire);
+	uint32_t space = m_capacity - (writePos - m_cachedReadPos);
+	if (space < count)
+	{
+		m_overruns.store(m_overruns.load(std::memory_order_relaxed) + (count - space), std::memory_order_relaxed);
+		count = space;
+	}
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t idx = ((writePos + i) & (m_capacity - 1)) * 2;
+		m_samples[idx] = frames[i * 2];
+		m_samples[idx + 1] = frames[(i * 2) + 1];
+	}
+	m_writePos.store(writePos + count, std::memory_order_release);
+}
+
+uint32_t AudioRing::getQueuedFrames()
+{
+	return m_writePos.load(std::memory_order_relaxed) - m_readPos.load(std::memory_order_acquire);
+}
+
+bool AudioRing::waitUntilDrained(uint32_t maxQueuedFrames, std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+	while (m_popped.try_acquire());		//anything left over from a pop that raced the end of the last wait
+	m_waiting.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);		//pairs with pop's fence: either it sees us waiting, or we see its read position
+	bool drained = true;
+	while (getQueuedFrames() > maxQueuedFrames)
+	{
+		if (!m_popped.try_acquire_until(deadline))
+		{
+			drained = false;
+			break;
+		}
+	}
+	m_waiting.store(false, std::memory_order_relaxed);
+	return drained;
+}
+
+void AudioRing::pop(float* out, uint32_t frames)
+{
+	uint32_t readPos = m_readPos.load(std::memory_order_relaxed);
+	uint32_t available = m_writePos.load(std::memory_order_acquire) - readPos;
+	uint32_t count = (available < frames) ? available : frames;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t idx = ((readPos + i) & (m_capacity - 1)) * 2;
+		out[i * 2] = m_samples[idx];
+		out[(i * 2) + 1] = m_samples[idx + 1];
+	}
+
+	if (count < frames)
+	{
+		memset(&out[count * 2], 0, (frames - count) * 2 * sizeof(float));
+		m_underruns.store(m_underruns.load(std::memory_order_relaxed) + (frames - count), std::memory_order_relaxed);
+	}
+
+	m_readPos.store(readPos + count, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (m_waiting.load(std::memory_order_relaxed))		//emu thread is waiting for space
+		m_popped.release();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include"Logger.h"
+
+#include<atomic>
+#include<memory>
+#include<semaphore>
+#include<chrono>
+
+//single producer/single consumer ring of stereo frames, from the emu thread (apu) to the audio thread. neither side ever locks:
+//if it's full the new frames are dropped (overrun), if it's empty the audio thread plays silence (underrun) - both are counted in frames
+class AudioRing
+{
+public:
+	AudioRing(uint32_t capacityFrames);		//must be a power of two
+	~AudioRing();
+
+	//emu thread side
+	void push(const float* frames, uint32_t count);	//interleaved L/R
+	uint32_t getQueuedFrames();
+	bool waitUntilDrained(uint32_t maxQueuedFrames, std::chrono::milliseconds timeout);	//blocks until the audio thread has drained it down to that many frames. false if it timed out first
+
+	//audio thread side
+	void pop(float* out, uint32_t frames);		//interleaved L/R, always fills all of 'out'
+
+	uint64_t getOverruns() { return m_overruns.load(std::memory_order_relaxed); }
+	uint64_t getUnderruns() { return m_underruns.load(std::memory_order_relaxed); }
+private:
+	uint32_t m_capacity = 0;
+	std::unique_ptr<float[]> m_samples;
+	std::atomic<uint32_t> m_writePos = 0;		//published by emu thread
+	std::atomic<uint32_t> m_readPos = 0;		//published by audio thread
+	uint32_t m_cachedReadPos = 0;				//emu thread's last look at m_readPos, so pushing doesn't touch the audio thread's cache line every time
+	std::counting_semaphore<> m_popped{ 0 };	//released after a pop, only while the emu thread is waiting on it
+	std::atomic<bool> m_waiting = false;
+
+	std::atomic<uint64_t> m_overruns = 0;
+	std::atomic<uint64_t> m_underruns = 0;
+};
@@ -0,0 +1,183 @@
+#include"AudioSink.h"
+
+#include<utility>
+#include<filesystem>
+
+std::unique_ptr<AudioSink> AudioSink::create(AudioSinkType type, const std::string& path, int sampleRate)
+{
+	switch (type)
+	{
+	case AudioSinkType::Device:
+		return std::make_unique<SDLAudioSink>(sampleRate);
+	case AudioSinkType::Null:
+		Logger::getInstance()->msg(LoggerSeverity::Info, "Audio disabled");
+		return std::make_unique<NullAudioSink>();
+	case AudioSinkType::WAVFile:
+	case AudioSinkType::RawFile:
+	case AudioSinkType::Pipe:
+		Logger::getInstance()->msg(LoggerSeverity::Info, std::format("Writing audio to {}", path));
+		return std::make_unique<PCMFileSink>(path, sampleRate, type == AudioSinkType::WAVFile, type == AudioSinkType::Pipe);
+	}
+	std::unreachable();		//every sink type has its case above
+}
+
+bool AudioSink::validateOutputPath(AudioSinkType type, const std::string& path)
+{
+	if (type == AudioSinkType::Device || type == AudioSinkType::Null)
+		return true;
+	if (path.empty())
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, "No audio output path set");
+		return false;
+	}
+	if (type == AudioSinkType::Pipe)		//the other end creates it, so there's nothing more to check until it's opened
+		return true;
+
+	std::error_code ec;
+	std::filesystem::path filePath(path);
+	if (std::filesystem::is_directory(filePath, ec))
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, std::format("Audio output {} is a directory", path));
+		return false;
+	}
+	if (filePath.has_parent_path() && !std::filesystem::is_directory(filePath.parent_path(), ec))
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, std::format("Audio output folder {} doesn't exist", filePath.parent_path().string()));
+		return false;
+	}
+	return true;
+}
+
+SDLAudioSink::SDLAudioSink(int sampleRate)
+{
+	SDL_Init(SDL_INIT_AUDIO);
+	SDL_AudioSpec desiredSpec = {}, obtainedSpec = {};
+	desiredSpec.freq = sampleRate;
+	desiredSpec.format = AUDIO_F32;
+	desiredSpec.channels = 2;
+	desiredSpec.silence = 0;
+	desiredSpec.samples = deviceBufferSize;
+	desiredSpec.callback = &SDLAudioSink::audioCallback;
+	desiredSpec.userdata = (void*)&m_ring;
+	m_audioDevice = SDL_OpenAudioDevice(nullptr, 0, &desiredSpec, &obtainedSpec, 0);
+	if (!m_audioDevice)
+		Logger::getInstance()->msg(LoggerSeverity::Error, std::format("Couldn't open audio device: {}", SDL_GetError()));
+	else		//a few callbacks' worth, so a slow device at a low rate doesn't count as stalled
+		m_stallTimeout = std::chrono::milliseconds((std::max)(500, (4 * obtainedSpec.samples * 1000) / (std::max)(obtainedSpec.freq, 1)));
+	SDL_PauseAudioDevice(m_audioDevice, 0);
+}
+
+SDLAudioSink::~SDLAudioSink()
+{
+	SDL_CloseAudioDevice(m_audioDevice);		//stops the callback before the ring goes away
+	SDL_Quit();
+}
+
+void SDLAudioSink::write(const float* frames, uint32_t count)
+{
+	m_ring.push(frames, count);
+	if (m_stalled && m_ring.getQueuedFrames() <= syncQueuedFrames && SDL_GetAudioDeviceStatus(m_audioDevice) == SDL_AUDIO_PLAYING)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Info, "Audio device is draining again, syncing to it");
+		m_stalled = false;
+	}
+	Config::GBA.audioOverruns = m_ring.getOverruns();
+	Config::GBA.audioUnderruns = m_ring.getUnderruns();
+}
+
+void SDLAudioSink::waitForDevice()
+{
+	auto giveUpTime = std::chrono::steady_clock::now() + m_stallTimeout;
+	while (!m_ring.waitUntilDrained(syncQueuedFrames, waitSlice))
+	{
+		if (Config::GBA.shouldReset)
+			return;
+		if (SDL_GetAudioDeviceStatus(m_audioDevice) != SDL_AUDIO_PLAYING || std::chrono::steady_clock::now() >= giveUpTime)
+		{
+			Logger::getInstance()->msg(LoggerSeverity::Warn, "Audio device stopped draining - pacing off the host clock instead");
+			m_stalled = true;
+			return;
+		}
+	}
+}
+
+void SDLCALL SDLAudioSink::audioCallback(void* userdata, Uint8* stream, int len)
+{
+	AudioRing* ring = (AudioRing*)userdata;
+	ring->pop((float*)stream, len / (sizeof(float) * 2));
+}
+
+PCMFileSink::PCMFileSink(const std::string& path, int sampleRate, bool wavHeader, bool streaming) : m_wavHeader(wavHeader), m_streaming(streaming), m_sampleRate(sampleRate)
+{
+	m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, std::format("Couldn't open audio output {}", path));
+		m_failed = true;
+		return;
+	}
+	m_buffer.reserve(writeBufferSize);
+	if (m_wavHeader)
+		writeWAVHeader();		//sizes get filled in on close
+}
+
+PCMFileSink::~PCMFileSink()
+{
+	if (m_failed)
+		return;
+	flushBuffer();
+	if (m_wavHeader)
+	{
+		m_file.seekp(0);
+		writeWAVHeader();
+	}
+}
+
+void PCMFileSink::write(const float* frames, uint32_t count)
+{
+	if (m_failed)
+		return;
+	for (uint32_t i = 0; i < count * 2; i++)
+	{
+		float sample = frames[i] * 32767.f;
+		sample = (sample > 32767.f) ? 32767.f : ((sample < -32768.f) ? -32768.f : sample);
+		m_buffer.push_back((int16_t)sample);
+	}
+	if (m_streaming || m_buffer.size() >= writeBufferSize)
+		flushBuffer();
+}
+
+void PCMFileSink::flushBuffer()
+{
+	if (m_buffer.empty())
+		return;
+	m_file.write((const char*)m_buffer.data(), m_buffer.size() * sizeof(int16_t));
+	if (m_streaming)
+		m_file.flush();
+	if (!m_file)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, "Audio output write failed, no more audio will be written");
+		m_failed = true;
+	}
+	m_dataBytes += m_buffer.size() * sizeof(int16_t);
+	m_buffer.clear();
+}
+
+void PCMFileSink::writeWAVHeader()
+{
+	auto write16 = [this](uint16_t val) { m_file.write((const char*)&val, 2); };
+	auto write32 = [this](uint32_t val) { m_file.write((const char*)&val, 4); };
+
+	m_file.write("RIFF", 4);
+	write32(36 + m_dataBytes);
+	m_file.write("WAVEfmt ", 8);
+	write32(16);					//fmt chunk size
+	write16(1);						//pcm
+	write16(2);						//channels
+	write32(m_sampleRate);
+	write32(m_sampleRate * 4);		//bytes per second
+	write16(4);						//bytes per frame
+	write16(16);					//bits per sample
+	m_file.write("data", 4);
+	write32(m_dataBytes);
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include"Logger.h"
+#include"Config.h"
+#include"AudioRing.h"
+
+#include<fstream>
+#include<vector>
+#include<memory>
+#include<SDL.h>
+#undef main			//really sdl??
+
+//where the apu's mixed output goes. the apu hands over blocks of interleaved L/R frames on the emu thread; only the device sink
+//can pace emulation, the rest never wait on anything but their own writes
+class AudioSink
+{
+public:
+	virtual ~AudioSink() {};
+
+	static std::unique_ptr<AudioSink> create(AudioSinkType type, const std::string& path, int sampleRate);
+	static bool validateOutputPath(AudioSinkType type, const std::string& path);	//false if a file/pipe sink has nowhere usable to write
+
+	virtual bool wantsSamples() { return true; }		//false = apu doesn't bother mixing at all
+	virtual bool canPace() { return false; }
+	virtual void write(const float* frames, uint32_t count) = 0;
+	virtual void waitForDevice() {};					//blocks until the device has consumed enough of what's been written
+};
+
+class NullAudioSink : public AudioSink
+{
+public:
+	bool wantsSamples() override { return false; }
+	void write(const float*, uint32_t) override {};
+};
+
+//sdl device, drained from the ring by sdl's audio thread
+class SDLAudioSink : public AudioSink
+{
+public:
+	SDLAudioSink(int sampleRate);
+	~SDLAudioSink();
+
+	bool canPace() override { return m_audioDevice != 0 && !m_stalled; }
+	void write(const float* frames, uint32_t count) override;
+	void waitForDevice() override;
+private:
+	static constexpr int deviceBufferSize = 2048;		//frames per callback
+	static constexpr int ringSize = 8192;
+	static constexpr int syncQueuedFrames = deviceBufferSize * 2;		//waitForDevice returns once no more than this is queued
+
+	SDL_AudioDeviceID m_audioDevice = {};
+	AudioRing m_ring{ ringSize };
+
+	//if the device stops pulling (unplugged, callback stopped), stop letting it pace us and fall back to the host clock until it drains again
+	static constexpr auto waitSlice = std::chrono::milliseconds(20);		//how often a wait rechecks for a reset
+	std::chrono::milliseconds m_stallTimeout{ 500 };
+	bool m_stalled = false;
+
+	static void SDLCALL audioCallback(void* userdata, Uint8* stream, int len);
+};
+
+//signed 16 bit stereo pcm to a file or pipe, optionally with a wav header. writes are batched up unless streaming, where each block
+//goes out as soon as it's mixed so whatever's reading the pipe isn't kept waiting
+class PCMFileSink : public AudioSink
+{
+public:
+	PCMFileSink(const std::string& path, int sampleRate, bool wavHeader, bool streaming);
+	~PCMFileSink();
+
+	void write(const float* frames, uint32_t count) override;
+private:
+	static constexpr int writeBufferSize = 32768;	//samples
+
+	std::ofstream m_file;
+	std::vector<int16_t> m_buffer;
+	bool m_wavHeader = false;
+	bool m_streaming = false;
+	bool m_failed = false;
+	uint32_t m_dataBytes = 0;
+	int m_sampleRate = 0;
+
+	void flushBuffer();
+	void writeWAVHeader();
+};
@@ -0,0 +1,131 @@
+#include"BackupBase.h"
+
+bool BackupBase::getSaveData(std::vector<uint8_t>& vec)
+{
+	std::string saveName = Config::GBA.RomName;
+	int extensionStartIdx = saveName.find_last_of('.');
+	saveName = saveName.substr(0, extensionStartIdx);
+	saveName += ".sav";
+
+	m_saveName = saveName;
+
+	// open the file (at the end, so we know its size straight away)
+	std::ifstream file(saveName, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Info, "No savefile associated with the current game - generating new file!");
+		return false;
+	}
+
+	std::streamsize fileSize = file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	// read the whole thing in one go
+	vec.resize(fileSize);
+	file.read((char*)vec.data(), fileSize);
+	file.close();
+
+	return true;
+}
+
+void BackupBase::startSaveFlush(int sizeBytes, bool fileValid)
+{
+	m_saveSizeBytes = sizeBytes;
+	m_dirtyPages.assign((sizeBytes + savePageSize - 1) / savePageSize, false);
+	m_pageScratch.resize(savePageSize);
+
+	if (!fileValid)
+	{
+		//create/truncate the file, then write out every page so it's the right size before we start patching pages in place
+		std::ofstream createHandle(m_saveName, std::ios::out | std::ios::binary | std::ios::trunc);
+		createHandle.close();
+		markDirty(0, sizeBytes);
+		commitDirtyPages();
+	}
+
+	m_stopFlushThread = false;
+	m_flushThread = std::thread(&BackupBase::flushThreadLoop, this);
+}
+
+void BackupBase::stopSaveFlush()
+{
+	if (!m_flushThread.joinable())
+		return;
+
+	commitDirtyPages();
+	{
+		std::lock_guard<std::mutex> lock(m_flushLock);
+		m_stopFlushThread = true;
+	}
+	m_flushCondition.notify_one();
+	m_flushThread.join();
+
+	writePendingPages(m_pendingPages);	//should already be empty, but make sure nothing is lost
+	m_pendingPages.clear();
+	Logger::getInstance()->msg(LoggerSeverity::Info, "Save data write completed!");
+}
+
+void BackupBase::commitDirtyPages()
+{
+	if (!m_anyDirty)
+		return;
+	m_anyDirty = false;
+
+	for (uint32_t page = 0; page < m_dirtyPages.size(); page++)
+	{
+		if (!m_dirtyPages[page])
+			continue;
+		m_dirtyPages[page] = false;
+
+		uint32_t offset = page * savePageSize;
+		int size = (std::min)((uint32_t)savePageSize, m_saveSizeBytes - offset);
+		readSaveBytes(offset, m_pageScratch.data(), size);
+
+		std::lock_guard<std::mutex> lock(m_flushLock);		//only held for the copy - the flush thread never holds this during file io
+		std::vector<uint8_t>& pageData = m_pendingPages[page];
+		if (pageData.empty() && !m_sparePages.empty())
+		{
+			pageData = std::move(m_sparePages.back());
+			m_sparePages.pop_back();
+		}
+		pageData.assign(m_pageScratch.begin(), m_pageScratch.begin() + size);
+	}
+}
+
+void BackupBase::flushThreadLoop()
+{
+	std::unique_lock<std::mutex> lock(m_flushLock);
+	while (!m_stopFlushThread)
+	{
+		m_flushCondition.wait_for(lock, std::chrono::milliseconds(Config::GBA.saveFlushInterval), [this] { return m_stopFlushThread; });
+
+		std::map<uint32_t, std::vector<uint8_t>> pages;
+		pages.swap(m_pendingPages);
+		lock.unlock();
+		writePendingPages(pages);
+		lock.lock();
+		for (auto& [page, data] : pages)		//hand the buffers back so committing pages doesn't have to allocate
+			m_sparePages.push_back(std::move(data));
+		pages.clear();
+	}
+}
+
+void BackupBase::writePendingPages(std::map<uint32_t, std::vector<uint8_t>>& pages)
+{
+	if (pages.empty())
+		return;
+
+	std::fstream saveWriteHandle(m_saveName, std::ios::in | std::ios::out | std::ios::binary);
+	if (!saveWriteHandle)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Error, "Failed to open save file for writing!");
+		return;
+	}
+
+	for (auto& [page, data] : pages)		//pages are in ascending order, so a freshly created file grows sequentially
+	{
+		saveWriteHandle.seekp((std::streamoff)page * savePageSize);
+		saveWriteHandle.write((const char*)data.data(), data.size());
+	}
+	saveWriteHandle.close();
+}
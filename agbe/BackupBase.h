@@ -3,6 +3,14 @@
 #include"Logger.h"
 #include"Config.h"
 
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<map>
+#include<vector>
+#include<chrono>
+#include<algorithm>
+
 enum class BackupType
 {
 	None,
@@ -20,59 +28,41 @@ public:
 	BackupBase(BackupType type) {};
 	~BackupBase() {};
 
-	virtual uint8_t read(uint32_t address) { return 0; };
-	virtual void write(uint32_t address, uint8_t value) {};
+	void commitDirtyPages();	//called on frame boundaries - copies out any modified pages so the flush thread can write them
 protected:
+	static constexpr int savePageSize = 4096;	//same as flash sector size, so a sector erase only dirties one page
+
 	std::string m_saveName;
 	int saveSize = 0;
-	bool getSaveData(std::vector<uint8_t>& vec)
-	{
-		std::string saveName = Config::GBA.RomName;
-		int extensionStartIdx = saveName.find_last_of('.');
-		saveName = saveName.substr(0, extensionStartIdx);
-		saveName += ".sav";
-
-		m_saveName = saveName;
-
-		// open the file:
-		std::ifstream file(saveName, std::ios::binary);
-		if (!file)
-		{
-			Logger::getInstance()->msg(LoggerSeverity::Info, "No savefile associated with the current game - generating new file!");
-			return false;
-		}
-
-		// Stop eating new lines in binary mode!!!
-		file.unsetf(std::ios::skipws);
-
-		// get its size:
-		std::streampos fileSize;
-
-		file.seekg(0, std::ios::end);
-		fileSize = file.tellg();
-		file.seekg(0, std::ios::beg);
+	bool getSaveData(std::vector<uint8_t>& vec);
 
-		// reserve capacity
-		vec.reserve(fileSize);
+	//each backup type stores its memory differently (e.g. eeprom keeps 64 bit words), so they provide the save file layout themselves
+	virtual void readSaveBytes(uint32_t, uint8_t*, int) {};
 
-		// read the data:
-		vec.insert(vec.begin(),
-			std::istream_iterator<uint8_t>(file),
-			std::istream_iterator<uint8_t>());
-
-		file.close();
-
-		return true;
-	}
-
-	void writeSaveData(void* saveData, int sizeBytes)
+	void startSaveFlush(int sizeBytes, bool fileValid);
+	void stopSaveFlush();
+	inline void markDirty(uint32_t offset, uint32_t size = 1)
 	{
-		Logger::getInstance()->msg(LoggerSeverity::Info, "Writing save data..");
-
-		std::ofstream saveWriteHandle(m_saveName, std::ios::out | std::ios::binary);
-		saveWriteHandle.write((const char*)saveData, sizeBytes);
-		saveWriteHandle.close();
-
-		Logger::getInstance()->msg(LoggerSeverity::Info, "Save data write completed!");
+		if (offset >= m_saveSizeBytes)
+			return;
+		uint32_t lastByte = (std::min)(offset + size, m_saveSizeBytes) - 1;
+		for (uint32_t page = offset / savePageSize; page <= lastByte / savePageSize; page++)
+			m_dirtyPages[page] = true;
+		m_anyDirty = true;
 	}
-};
\ No newline at end of file
+private:
+	uint32_t m_saveSizeBytes = 0;
+	std::vector<bool> m_dirtyPages;
+	bool m_anyDirty = false;
+	std::vector<uint8_t> m_pageScratch;		//pages are read out into this, then copied into a pending buffer under the lock
+
+	std::thread m_flushThread;
+	std::mutex m_flushLock;
+	std::condition_variable m_flushCondition;
+	bool m_stopFlushThread = false;
+	std::map<uint32_t, std::vector<uint8_t>> m_pendingPages;	//page idx -> page contents, only touched with m_flushLock held
+	std::vector<std::vector<uint8_t>> m_sparePages;				//buffers of pages already written, reused for the next ones. also under m_flushLock
+
+	void flushThreadLoop();
+	void writePendingPages(std::map<uint32_t, std::vector<uint8_t>>& pages);
+};
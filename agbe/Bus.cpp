@@ -1,22 +1,12 @@
 #include"Bus.h"
 
-Bus::Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<PPU> ppu, std::shared_ptr<Input> input, std::shared_ptr<Scheduler> scheduler)
+Bus::Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, GBAMem& mem, InterruptManager& interruptManager, PPU& ppu, Input& input, Scheduler& scheduler, Debugger& debugger)
+	: m_scheduler(scheduler), m_mem(mem), m_interruptManager(interruptManager), m_ppu(ppu), m_input(input), m_debugger(debugger), m_timer(interruptManager, scheduler), m_apu(scheduler), m_serial(scheduler, interruptManager)
 {
-	m_scheduler = scheduler;
-	m_interruptManager = interruptManager;
-	m_ppu = ppu;
-	m_input = input;
-
-	m_mem = std::make_shared<GBAMem>();
-	m_timer = std::make_shared<Timer>(m_interruptManager,m_scheduler);
-	m_apu = std::make_shared<APU>(m_scheduler);
-	m_timer->registerAPUCallbacks((callbackFn)&APU::timer0Callback, (callbackFn)&APU::timer1Callback, (void*)m_apu.get());
-	m_apu->registerDMACallback((FIFOcallbackFn)&Bus::DMA_AudioFIFOCallback, (void*)this);
-	m_serial = std::make_shared<SerialStub>(m_scheduler, m_interruptManager);
-	m_rtc = std::make_shared<RTC>();
-
-	m_ppu->registerMemory(m_mem);
-	m_ppu->registerDMACallbacks(&Bus::DMA_HBlankCallback, &Bus::DMA_VBlankCallback, &Bus::DMA_VideoCaptureCallback, (void*)this);
+	m_timer.registerAPUCallbacks((callbackFn)&APU::timer0Callback, (callbackFn)&APU::timer1Callback, (void*)&m_apu);
+	m_apu.registerDMACallback((FIFOcallbackFn)&Bus::DMA_AudioFIFOCallback, (void*)this);
+
+	m_ppu.registerDMACallbacks(&Bus::DMA_HBlankCallback, &Bus::DMA_VBlankCallback, &Bus::DMA_VideoCaptureCallback, (void*)this);
 	if (BIOS.size() != 16384)
 	{
 		std::cout << BIOS.size() << '\n';
@@ -36,15 +26,15 @@ Bus::Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, std::shared_p
 	for (int i = 0; i < (32 * 1024 * 1024); i += 2)
 	{
 		uint32_t oobVal = (i >> 1) & 0xFFFF;
-		m_mem->ROM[i] = oobVal & 0xFF;
-		m_mem->ROM[i + 1] = (oobVal >> 8) & 0xFF;
+		m_mem.ROM[i] = oobVal & 0xFF;
+		m_mem.ROM[i + 1] = (oobVal >> 8) & 0xFF;
 	}
 
-	memcpy(m_mem->BIOS, &BIOS[0], BIOS.size());
-	memcpy(m_mem->ROM, &cartData[0], cartData.size());	
+	memcpy(m_mem.BIOS, &BIOS[0], BIOS.size());
+	memcpy(m_mem.ROM, &cartData[0], cartData.size());	
 
 
-	auto romAsString = std::string_view(reinterpret_cast<const char*>(m_mem->ROM), 32 * 1024 * 1024);
+	auto romAsString = std::string_view(reinterpret_cast<const char*>(m_mem.ROM), 32 * 1024 * 1024);
 	attemptSaveAutodetection(romAsString);
 
 	if (romSize == 1048576)
@@ -53,8 +43,16 @@ Bus::Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, std::shared_p
 
 Bus::~Bus()
 {
-	m_mem.reset();
-	m_timer.reset();
+
+}
+
+void Bus::commitBackupMemory()
+{
+	std::visit([](auto& backup)
+	{
+		if constexpr (!std::is_same_v<std::decay_t<decltype(backup)>, std::monostate>)
+			backup.commitDirtyPages();
+	}, m_backupMemory);
 }
 
 void Bus::attemptSaveAutodetection(std::string_view& romData)
@@ -65,29 +63,34 @@ void Bus::attemptSaveAutodetection(std::string_view& romData)
 		backupInitialised = true;
 		Logger::getInstance()->msg(LoggerSeverity::Info, "Init 512Kbit flash memory!!");
 		m_backupType = BackupType::FLASH512K;
-		m_backupMemory = std::make_shared<Flash>(m_backupType);
+		m_backupMemory.emplace<Flash>(m_backupType);
 	}
 	else if (romData.find("FLASH1M") != std::string::npos)
 	{
 		backupInitialised = true;
 		Logger::getInstance()->msg(LoggerSeverity::Info, "Init 1Mbit flash memory!!");
 		m_backupType = BackupType::FLASH1M;
-		m_backupMemory = std::make_shared<Flash>(m_backupType);
+		m_backupMemory.emplace<Flash>(m_backupType);
 	}
 	else if (romData.find("SRAM") != std::string::npos)
 	{
 		backupInitialised = true;
 		Logger::getInstance()->msg(LoggerSeverity::Info, "Init SRAM backup memory!!");
 		m_backupType = BackupType::SRAM;
-		m_backupMemory = std::make_shared<SRAM>(m_backupType);
+		m_backupMemory.emplace<SRAM>(m_backupType);
 	}
 
 	if (!backupInitialised)
 		Logger::getInstance()->msg(LoggerSeverity::Warn, "Failed to auto-detect savetype. The ROM may be using EEPROM or masking its savetype!");
 }
 
-uint8_t Bus::read8(uint32_t address, AccessType accessType)
+template<bool debug> uint8_t Bus::read8(uint32_t address, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address, 1, false);
+	}
 	int cartCycles = 0;
 	uint8_t page = (address >> 24) & 0xFF;
 	switch (page)
@@ -100,55 +103,62 @@ uint8_t Bus::read8(uint32_t address, AccessType accessType)
 				return std::rotr(m_openBusVals.bios, 8*(address&0b11));	//todo: account for the value being rotated properly
 			return std::rotr(m_openBusVals.mem, 8*(address&0b11));
 		}
-		return m_mem->BIOS[address & 0x3FFF];
+		return m_mem.BIOS[address & 0x3FFF];
 	case 2:
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		tickPrefetcher(3);
-		return m_mem->externalWRAM[address & 0x3FFFF];
+		return m_mem.externalWRAM[address & 0x3FFFF];
 	case 3:
 		tickPrefetcher(1);
-		return m_mem->internalWRAM[address & 0x7FFF];
+		return m_mem.internalWRAM[address & 0x7FFF];
 	case 4:
 		tickPrefetcher(1);
 		return readIO8(address);
 	case 5:
 		tickPrefetcher(1);
-		return m_mem->paletteRAM[address & 0x3FF];
+		return m_mem.paletteRAM[address & 0x3FF];
 	case 6:
 		tickPrefetcher(1);
 		address = address & 0x1FFFF;
 		if (address >= 0x18000)
 			address -= 32768;
-		return m_mem->VRAM[address];
+		return m_mem.VRAM[address];
 	case 7:
 		tickPrefetcher(1);
-		return m_mem->OAM[address & 0x3FF];
+		return m_mem.OAM[address & 0x3FF];
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:	//need to do this better (different waitstates will have different timings)
 		cartCycles = ((accessType==AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
-		m_scheduler->addCycles(cartCycles);
+		m_scheduler.addCycles(cartCycles);
 		if (prefetchInProgress && prefetchShouldDelay)
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		prefetchShouldDelay = false;
 		invalidatePrefetchBuffer();
-		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc->getRegistersReadable())
-			return m_rtc->read(address);
-		return m_mem->ROM[address & romAddressMask];
+		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc.getRegistersReadable())
+			return m_rtc.read(address);
+		return m_mem.ROM[address & romAddressMask];
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);	//hm.
+		m_scheduler.addCycles(SRAMCycles);	//hm.
 		if (prefetchInProgress && prefetchShouldDelay)
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		prefetchShouldDelay = false;
 		invalidatePrefetchBuffer();
-		if (m_backupType == BackupType::FLASH1M || m_backupType == BackupType::FLASH512K || m_backupType == BackupType::SRAM)
-			return m_backupMemory->read(address);
+		if (Flash* flash = std::get_if<Flash>(&m_backupMemory))
+			return flash->read(address);
+		if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
+			return sram->read(address);
 	}
 
 	tickPrefetcher(1);
 	return m_openBusVals.mem;
 }
 
-void Bus::write8(uint32_t address, uint8_t value, AccessType accessType)
+template<bool debug> void Bus::write8(uint32_t address, uint8_t value, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address, 1, true);
+	}
 	int cartCycles = 0;
 	uint8_t page = (address >> 24) & 0xFF;
 	switch (page)
@@ -157,13 +167,13 @@ void Bus::write8(uint32_t address, uint8_t value, AccessType accessType)
 		tickPrefetcher(1);
 		break;
 	case 2:
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		tickPrefetcher(3);
-		m_mem->externalWRAM[address & 0x3FFFF] = value;
+		m_mem.externalWRAM[address & 0x3FFFF] = value;
 		break;
 	case 3:
 		tickPrefetcher(1);
-		m_mem->internalWRAM[address & 0x7FFF] = value;
+		m_mem.internalWRAM[address & 0x7FFF] = value;
 		break;
 	case 4:
 		tickPrefetcher(1);
@@ -171,39 +181,44 @@ void Bus::write8(uint32_t address, uint8_t value, AccessType accessType)
 
 		//8/16 bit writes to audio fifos will cause an entire word to be pushed, weird.
 		if (address>=0x040000A0 && address<=0x040000A7)
-			m_apu->advanceSamplePtr((address&7) >>2);
+			m_apu.advanceSamplePtr((address&7) >>2);
 
 		break;
 	case 5:
 		tickPrefetcher(1);
-		m_mem->paletteRAM[address & 0x3FF] = value;
-		m_mem->paletteRAM[(address + 1) & 0x3FF] = value;
+		m_mem.paletteRAM[address & 0x3FF] = value;
+		m_mem.paletteRAM[(address + 1) & 0x3FF] = value;
+		m_ppu.onPaletteWrite(address);
+		m_ppu.onPaletteWrite(address + 1);
 		break;
 	case 6:
 		tickPrefetcher(1);
 		address = address & 0x1FFFE;
 		if (address >= 0x18000)
 			address -= 32768;
-		if ((m_ppu->getBitmapMode() && address>0x13FFF) || (!m_ppu->getBitmapMode() && address>0xFFFF))
+		if ((m_ppu.getBitmapMode() && address>0x13FFF) || (!m_ppu.getBitmapMode() && address>0xFFFF))
 			break;
-		m_mem->VRAM[address]=value;
-		m_mem->VRAM[address + 1] = value;
+		m_mem.VRAM[address]=value;
+		m_mem.VRAM[address + 1] = value;
+		m_ppu.onVRAMWrite(address, 2);
 		break;
 	case 7:
 		tickPrefetcher(1);
 		break;
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:
 		cartCycles = ((accessType==AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
-		m_scheduler->addCycles(cartCycles);
+		m_scheduler.addCycles(cartCycles);
 		if (prefetchInProgress && prefetchShouldDelay)
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		prefetchShouldDelay = false;
 		invalidatePrefetchBuffer();
 		break;
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);
-		if (m_backupType == BackupType::FLASH1M || m_backupType == BackupType::FLASH512K || m_backupType == BackupType::SRAM)
-			m_backupMemory->write(address, value);
+		m_scheduler.addCycles(SRAMCycles);
+		if (Flash* flash = std::get_if<Flash>(&m_backupMemory))
+			flash->write(address, value);
+		else if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
+			sram->write(address, value);
 		break;
 	default:
 		tickPrefetcher(1);
@@ -211,8 +226,13 @@ void Bus::write8(uint32_t address, uint8_t value, AccessType accessType)
 	}
 }
 
-uint16_t Bus::read16(uint32_t address, AccessType accessType)
+template<bool debug> uint16_t Bus::read16(uint32_t address, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address & ~0b1, 2, false);
+	}
 	int cartCycles = 0;
 	uint32_t originalAddress = address;
 	address &= 0xFFFFFFFE;
@@ -227,52 +247,52 @@ uint16_t Bus::read16(uint32_t address, AccessType accessType)
 				return m_openBusVals.bios;	//todo: account for the value being rotated properly
 			return m_openBusVals.mem;
 		}
-		return getValue16(m_mem->BIOS, address & 0x3FFF, 0x3FFF);
+		return getValue16(m_mem.BIOS, address & 0x3FFF, 0x3FFF);
 	case 2:
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		tickPrefetcher(3);
-		return getValue16(m_mem->externalWRAM, address & 0x3FFFF, 0x3FFFF);
+		return getValue16(m_mem.externalWRAM, address & 0x3FFFF, 0x3FFFF);
 	case 3:
 		tickPrefetcher(1);
-		return getValue16(m_mem->internalWRAM, address & 0x7FFF, 0x7FFF);
+		return getValue16(m_mem.internalWRAM, address & 0x7FFF, 0x7FFF);
 	case 4:
 		tickPrefetcher(1);
 		return readIO16(address);
 	case 5:
 		tickPrefetcher(1);
-		return getValue16(m_mem->paletteRAM, address & 0x3FF,0x3FF);
+		return getValue16(m_mem.paletteRAM, address & 0x3FF,0x3FF);
 	case 6:
 		tickPrefetcher(1);
 		address = address & 0x1FFFF;
 		if (address >= 0x18000)
 			address -= 32768;
-		return getValue16(m_mem->VRAM, address,0xFFFFFFFF);
+		return getValue16(m_mem.VRAM, address,0xFFFFFFFF);
 	case 7:
 		tickPrefetcher(1);
-		return getValue16(m_mem->OAM, address & 0x3FF,0x3FF);
+		return getValue16(m_mem.OAM, address & 0x3FF,0x3FF);
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:
 		dmaNonsequentialAccess = false;
 		cartCycles = ((accessType==AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
 		if (accessType != AccessType::Prefetch)
 		{
 			if (prefetchInProgress && prefetchShouldDelay)
-				m_scheduler->addCycles(1);
+				m_scheduler.addCycles(1);
 			prefetchShouldDelay = false;
 			invalidatePrefetchBuffer();
-			m_scheduler->addCycles(cartCycles);
+			m_scheduler.addCycles(cartCycles);
 		}
-		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc->getRegistersReadable())
-			return m_rtc->read(address);
+		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc.getRegistersReadable())
+			return m_rtc.read(address);
 		if (page==0xD)
 		{
-			if(m_backupType == BackupType::EEPROM4K || m_backupType == BackupType::EEPROM64K)
-				return m_backupMemory->read(address);
+			if (EEPROM* eeprom = std::get_if<EEPROM>(&m_backupMemory))
+				return eeprom->read(address);
 		}
-		return getValue16(m_mem->ROM, address & romAddressMask,0xFFFFFFFF);
+		return getValue16(m_mem.ROM, address & romAddressMask,0xFFFFFFFF);
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);
-		if (m_backupType == BackupType::SRAM)
-			return ((uint16_t)m_backupMemory->read(originalAddress)) * 0x0101;
+		m_scheduler.addCycles(SRAMCycles);
+		if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
+			return ((uint16_t)sram->read(originalAddress)) * 0x0101;
 	}
 
 	tickPrefetcher(1);
@@ -286,8 +306,13 @@ uint16_t Bus::read16(uint32_t address, AccessType accessType)
 	return m_openBusVals.mem;
 }
 
-void Bus::write16(uint32_t address, uint16_t value, AccessType accessType)
+template<bool debug> void Bus::write16(uint32_t address, uint16_t value, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address & ~0b1, 2, true);
+	}
 	int cartCycles = 0;
 	uint32_t originalAddress = address;
 	address &= 0xFFFFFFFE;
@@ -298,13 +323,13 @@ void Bus::write16(uint32_t address, uint16_t value, AccessType accessType)
 		tickPrefetcher(1);
 		break;
 	case 2:
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		tickPrefetcher(3);
-		setValue16(m_mem->externalWRAM, address & 0x3FFFF, 0x3FFFF, value);
+		setValue16(m_mem.externalWRAM, address & 0x3FFFF, 0x3FFFF, value);
 		break;
 	case 3:
 		tickPrefetcher(1);
-		setValue16(m_mem->internalWRAM, address & 0x7FFF, 0x7FFF, value);
+		setValue16(m_mem.internalWRAM, address & 0x7FFF, 0x7FFF, value);
 		break;
 	case 4:
 		tickPrefetcher(1);
@@ -312,46 +337,49 @@ void Bus::write16(uint32_t address, uint16_t value, AccessType accessType)
 
 		//similar for 8 bit writes, but 16 bit writes will modify part of the current word in the audio fifo, then advance the write ptr to the next word..
 		if ((address == 0x040000A0 || address == 0x040000A2 || address == 0x040000A4 || address == 0x040000A6))
-			m_apu->advanceSamplePtr((address & 7) >> 2);
+			m_apu.advanceSamplePtr((address & 7) >> 2);
 
 		break;
 	case 5:
 		tickPrefetcher(1);
-		setValue16(m_mem->paletteRAM, address & 0x3FF, 0x3FF, value);
+		setValue16(m_mem.paletteRAM, address & 0x3FF, 0x3FF, value);
+		m_ppu.onPaletteWrite(address);
 		break;
 	case 6:
 		tickPrefetcher(1);
 		address = address & 0x1FFFF;
 		if (address >= 0x18000)
 			address -= 32768;
-		setValue16(m_mem->VRAM, address, 0xFFFFFFFF, value);
+		setValue16(m_mem.VRAM, address, 0xFFFFFFFF, value);
+		m_ppu.onVRAMWrite(address, 2);
 		break;
 	case 7:
 		tickPrefetcher(1);
-		setValue16(m_mem->OAM, address & 0x3FF, 0x3FF, value);
+		setValue16(m_mem.OAM, address & 0x3FF, 0x3FF, value);
+		m_ppu.onOAMWrite(address & 0x3FF, 2);
 		break;
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:
 		dmaNonsequentialAccess = false;
 		cartCycles = ((accessType==AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
-		m_scheduler->addCycles(cartCycles);
+		m_scheduler.addCycles(cartCycles);
 		if (prefetchInProgress && prefetchShouldDelay)
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		prefetchShouldDelay = false;
 		invalidatePrefetchBuffer();
 		if (address >= 0x080000C4 && address <= 0x080000C9)
-			m_rtc->write16(address, value);
-		if (page==0xD && (m_backupType == BackupType::EEPROM4K || m_backupType == BackupType::EEPROM64K))
+			m_rtc.write16(address, value);
+		if (EEPROM* eeprom = std::get_if<EEPROM>(&m_backupMemory); eeprom && page == 0xD)
 		{
-			m_backupMemory->write(address, value);
+			eeprom->write(address, value);
 			break;
 		}
 		break;
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);
-		if (m_backupType == BackupType::SRAM)
+		m_scheduler.addCycles(SRAMCycles);
+		if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
 		{
 			value = (std::rotr(value, (originalAddress * 8))) & 0xFF;
-			m_backupMemory->write(originalAddress, value);
+			sram->write(originalAddress, value);
 		}
 		break;
 	default:
@@ -360,8 +388,13 @@ void Bus::write16(uint32_t address, uint16_t value, AccessType accessType)
 	}
 }
 
-uint32_t Bus::read32(uint32_t address, AccessType accessType)
+template<bool debug> uint32_t Bus::read32(uint32_t address, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address & ~0b11, 4, false);
+	}
 	int cartCycles = 0;
 	uint32_t originalAddress = address;
 	address &= 0xFFFFFFFC;
@@ -376,51 +409,51 @@ uint32_t Bus::read32(uint32_t address, AccessType accessType)
 				return m_openBusVals.bios;
 			return m_openBusVals.mem;
 		}
-		m_openBusVals.bios = getValue32(m_mem->BIOS, address & 0x3FFF, 0x3FFF);
+		m_openBusVals.bios = getValue32(m_mem.BIOS, address & 0x3FFF, 0x3FFF);
 		return m_openBusVals.bios;
 	case 2:
-		m_scheduler->addCycles(5);	//5 bc first access is 2 waitstates, then another access happens which is 1S + 2 waitstates
+		m_scheduler.addCycles(5);	//5 bc first access is 2 waitstates, then another access happens which is 1S + 2 waitstates
 		tickPrefetcher(6);
-		return getValue32(m_mem->externalWRAM, address & 0x3FFFF,0x3FFFF);
+		return getValue32(m_mem.externalWRAM, address & 0x3FFFF,0x3FFFF);
 	case 3:
 		tickPrefetcher(1);
-		return getValue32(m_mem->internalWRAM, address & 0x7FFF,0x7FFF);
+		return getValue32(m_mem.internalWRAM, address & 0x7FFF,0x7FFF);
 	case 4:
 		tickPrefetcher(1);
 		return readIO32(address);
 	case 5:
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		tickPrefetcher(2);
-		return getValue32(m_mem->paletteRAM, address & 0x3FF,0x3FF);
+		return getValue32(m_mem.paletteRAM, address & 0x3FF,0x3FF);
 	case 6:
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		tickPrefetcher(2);
 		address = address & 0x1FFFF;
 		if (address >= 0x18000)
 			address -= 32768;
-		return getValue32(m_mem->VRAM, address,0xFFFFFFFF);
+		return getValue32(m_mem.VRAM, address,0xFFFFFFFF);
 	case 7:
 		tickPrefetcher(1);
-		return getValue32(m_mem->OAM, address & 0x3FF,0x3FF);
+		return getValue32(m_mem.OAM, address & 0x3FF,0x3FF);
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:
 		dmaNonsequentialAccess = false;
 		cartCycles = ((accessType == AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
 		cartCycles += waitstateSequentialTable[((page - 8) >> 1)];
-		m_scheduler->addCycles(cartCycles + 1);	//first access is either nonseq/seq. second is *always* seq
+		m_scheduler.addCycles(cartCycles + 1);	//first access is either nonseq/seq. second is *always* seq
 		if (accessType != AccessType::Prefetch)
 		{
 			if (prefetchShouldDelay && prefetchInProgress)
-				m_scheduler->addCycles(1);
+				m_scheduler.addCycles(1);
 			prefetchShouldDelay = false;
 			invalidatePrefetchBuffer();
 		}
-		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc->getRegistersReadable())
-			return m_rtc->read(address);
-		return getValue32(m_mem->ROM, address & romAddressMask, 0xFFFFFFFF);
+		if (address >= 0x080000C4 && address <= 0x080000C9 && m_rtc.getRegistersReadable())
+			return m_rtc.read(address);
+		return getValue32(m_mem.ROM, address & romAddressMask, 0xFFFFFFFF);
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);
-		if (m_backupType == BackupType::SRAM)
-			return ((uint32_t)m_backupMemory->read(originalAddress)) * 0x01010101;
+		m_scheduler.addCycles(SRAMCycles);
+		if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
+			return ((uint32_t)sram->read(originalAddress)) * 0x01010101;
 	}
 
 	tickPrefetcher(1);
@@ -432,8 +465,13 @@ uint32_t Bus::read32(uint32_t address, AccessType accessType)
 	return m_openBusVals.mem;
 }
 
-void Bus::write32(uint32_t address, uint32_t value, AccessType accessType)
+template<bool debug> void Bus::write32(uint32_t address, uint32_t value, AccessType accessType)
 {
+	if constexpr (debug)
+	{
+		if (m_debugger.getPageWatched(address)) [[unlikely]]
+			m_debugger.checkWatchpoint(address & ~0b11, 4, true);
+	}
 	int cartCycles = 0;
 	uint32_t originalAddress = address;
 	address &= 0xFFFFFFFC;
@@ -444,13 +482,13 @@ void Bus::write32(uint32_t address, uint32_t value, AccessType accessType)
 		tickPrefetcher(1);
 		break;
 	case 2:
-		m_scheduler->addCycles(5);
+		m_scheduler.addCycles(5);
 		tickPrefetcher(6);
-		setValue32(m_mem->externalWRAM, address & 0x3FFFF, 0x3FFFF, value);
+		setValue32(m_mem.externalWRAM, address & 0x3FFFF, 0x3FFFF, value);
 		break;
 	case 3:
 		tickPrefetcher(1);
-		setValue32(m_mem->internalWRAM, address & 0x7FFF, 0x7FFF, value);
+		setValue32(m_mem.internalWRAM, address & 0x7FFF, 0x7FFF, value);
 		break;
 	case 4:
 		tickPrefetcher(1);
@@ -458,42 +496,46 @@ void Bus::write32(uint32_t address, uint32_t value, AccessType accessType)
 
 		//standard behaviour for audio fifos - i.e. write and push an entire word at once
 		if ((address == 0x040000A0 || address == 0x040000A4))
-			m_apu->advanceSamplePtr((address & 7) >> 2);
+			m_apu.advanceSamplePtr((address & 7) >> 2);
 
 		break;
 	case 5:
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		tickPrefetcher(1);
-		setValue32(m_mem->paletteRAM, address & 0x3FF, 0x3FF, value);
+		setValue32(m_mem.paletteRAM, address & 0x3FF, 0x3FF, value);
+		m_ppu.onPaletteWrite(address);
+		m_ppu.onPaletteWrite(address + 2);
 		break;
 	case 6:
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		tickPrefetcher(1);
 		address = address & 0x1FFFF;
 		if (address >= 0x18000)
 			address -= 32768;
-		setValue32(m_mem->VRAM, address, 0xFFFFFFFF, value);
+		setValue32(m_mem.VRAM, address, 0xFFFFFFFF, value);
+		m_ppu.onVRAMWrite(address, 4);
 		break;
 	case 7:
 		tickPrefetcher(1);
-		setValue32(m_mem->OAM, address & 0x3FF, 0x3FF, value);
+		setValue32(m_mem.OAM, address & 0x3FF, 0x3FF, value);
+		m_ppu.onOAMWrite(address & 0x3FF, 4);
 		break;
 	case 8: case 9: case 0xA: case 0xB: case 0xC: case 0xD:
 		dmaNonsequentialAccess = false;
 		cartCycles = ((accessType==AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
 		cartCycles += waitstateSequentialTable[((page - 8) >> 1)];
-		m_scheduler->addCycles(cartCycles + 1);	//same setup as for read32
+		m_scheduler.addCycles(cartCycles + 1);	//same setup as for read32
 		if (prefetchInProgress && prefetchShouldDelay)
-			m_scheduler->addCycles(1);
+			m_scheduler.addCycles(1);
 		prefetchShouldDelay = false;
 		invalidatePrefetchBuffer();
 		if (address >= 0x080000C4 && address <= 0x080000C9)
-			m_rtc->write32(address, value);
+			m_rtc.write32(address, value);
 		break;
 	case 0xE: case 0xF:
-		m_scheduler->addCycles(SRAMCycles);
-		if (m_backupType == BackupType::SRAM)
-			m_backupMemory->write(originalAddress, (std::rotr(value, originalAddress * 8) & 0xFF));
+		m_scheduler.addCycles(SRAMCycles);
+		if (SRAM* sram = std::get_if<SRAM>(&m_backupMemory))
+			sram->write(originalAddress, (std::rotr(value, originalAddress * 8) & 0xFF));
 		break;
 	default:
 		tickPrefetcher(1);
@@ -522,7 +564,7 @@ uint32_t Bus::fetch32(uint32_t address, AccessType accessType)
 			uint16_t valHigh = getPrefetchedValue(address + 2);
 			val = ((valHigh << 16) | valLow);
 			if (!hack_lastPrefetchGood)
-				m_scheduler->addCycles(1);		//not sure: seems like a cycle added if we end up having to do a halfword fetch.. :(
+				m_scheduler.addCycles(1);		//not sure: seems like a cycle added if we end up having to do a halfword fetch.. :(
 		}
 		else
 		{
@@ -612,7 +654,7 @@ uint16_t Bus::getPrefetchedValue(uint32_t pc)
 		{
 			uint8_t page = (pc >> 24) & 0xFF;
 			uint64_t waitstates = waitstateSequentialTable[((page - 8) >> 1)];
-			m_scheduler->addCycles(waitstates - prefetchInternalCycles);
+			m_scheduler.addCycles(waitstates - prefetchInternalCycles);
 			invalidatePrefetchBuffer();
 			prefetchInProgress = true;
 			prefetchAddress = pc + 2;
@@ -643,7 +685,7 @@ uint8_t Bus::readIO8(uint32_t address)
 	case 0x04000000: case 0x04000001: case 0x04000002: case 0x04000003: case 0x04000004: case 0x04000005: case 0x04000006: case 0x04000007:
 	case 0x04000008: case 0x04000009: case 0x0400000A: case 0x0400000B: case 0x0400000C: case 0x0400000D: case 0x0400000E: case 0x0400000F:
 	case 0x04000048: case 0x04000049: case 0x0400004A: case 0x0400004B: case 0x04000050: case 0x04000051: case 0x04000052: case 0x04000053:
-		return m_ppu->readIO(address);
+		return m_ppu.readIO(address);
 	case 0x04000060: case 0x04000061: case 0x04000062: case 0x04000063: case 0x04000064: case 0x04000065: case 0x04000066: case 0x04000067:
 	case 0x04000068: case 0x04000069: case 0x0400006a: case 0x0400006b: case 0x0400006c: case 0x0400006d: case 0x0400006e: case 0x0400006f:
 	case 0x04000070: case 0x04000071: case 0x04000072: case 0x04000073: case 0x04000074: case 0x04000075: case 0x04000076: case 0x04000077:
@@ -652,19 +694,19 @@ uint8_t Bus::readIO8(uint32_t address)
 	case 0x04000088: case 0x04000089: case 0x0400008a: case 0x0400008b:	//..8c,..8d,..8e,..8f aren't readable :(
 	case 0x04000090: case 0x04000091: case 0x04000092: case 0x04000093: case 0x04000094: case 0x04000095: case 0x04000096: case 0x04000097:
 	case 0x04000098: case 0x04000099: case 0x0400009a: case 0x0400009b: case 0x0400009c: case 0x0400009d: case 0x0400009e: case 0x0400009f:
-		return m_apu->readIO(address);
+		return m_apu.readIO(address);
 	case 0x040000B8: case 0x040000B9: case 0x040000BA: case 0x040000BB: case 0x040000C4: case 0x040000C5: case 0x040000C6: case 0x040000C7:
 	case 0x040000D0: case 0x040000D1: case 0x040000D2: case 0x040000D3: case 0x040000DC: case 0x040000DD: case 0x040000DE: case 0x040000DF:
 		return DMARegRead(address);
 	case 0x04000100: case 0x04000101: case 0x04000102: case 0x04000103: case 0x04000104: case 0x04000105: case 0x04000106: case 0x04000107:
 	case 0x04000108: case 0x04000109: case 0x0400010a: case 0x0400010b: case 0x0400010c: case 0x0400010d: case 0x0400010e: case 0x0400010f:
-		return m_timer->readIO(address);
+		return m_timer.readIO(address);
 	case 0x04000130: case 0x04000131: case 0x04000132: case 0x04000133:
-		return m_input->readIORegister(address);
+		return m_input.readIORegister(address);
 	case 0x04000200:case 0x04000201: case 0x04000202:  case 0x04000203: case 0x04000208: case 0x04000209: case 0x0400020A: case 0x0400020B:
-		return m_interruptManager->readIO(address);
+		return m_interruptManager.readIO(address);
 	case 0x04000120: case 0x04000121: case 0x04000122: case 0x04000123: case 0x0400012A: case 0x04000128: case 0x04000129:
-		return m_serial->readIO(address);
+		return m_serial.readIO(address);
 	case 0x04000204:
 		return WAITCNT & 0xFF;
 	case 0x04000205:
@@ -692,7 +734,7 @@ void Bus::writeIO8(uint32_t address, uint8_t value)
 	case 0x04000040: case 0x04000041: case 0x04000042: case 0x04000043: case 0x04000044: case 0x04000045: case 0x04000046: case 0x04000047: 
 	case 0x04000048: case 0x04000049: case 0x0400004a: case 0x0400004b: case 0x0400004c: case 0x0400004d: case 0x0400004e: case 0x0400004f: 
 	case 0x04000050: case 0x04000051: case 0x04000052: case 0x04000053: case 0x04000054: case 0x04000055: case 0x04000056:
-		m_ppu->writeIO(address, value);
+		m_ppu.writeIO(address, value);
 		return;
 	case 0x04000060: case 0x04000061: case 0x04000062: case 0x04000063: case 0x04000064: case 0x04000065: case 0x04000066: case 0x04000067:
 	case 0x04000068: case 0x04000069: case 0x0400006a: case 0x0400006b: case 0x0400006c: case 0x0400006d: case 0x0400006e: case 0x0400006f:
@@ -704,7 +746,7 @@ void Bus::writeIO8(uint32_t address, uint8_t value)
 	case 0x04000098: case 0x04000099: case 0x0400009a: case 0x0400009b: case 0x0400009c: case 0x0400009d: case 0x0400009e: case 0x0400009f:
 	case 0x040000a0: case 0x040000a1: case 0x040000a2: case 0x040000a3: case 0x040000a4: case 0x040000a5: case 0x040000a6: case 0x040000a7:
 	case 0x040000a8:
-		m_apu->writeIO(address, value);
+		m_apu.writeIO(address, value);
 		return;
 	case 0x040000b0: case 0x040000b1: case 0x040000b2: case 0x040000b3: case 0x040000b4: case 0x040000b5: case 0x040000b6: case 0x040000b7:
 	case 0x040000b8: case 0x040000b9: case 0x040000ba: case 0x040000bb: case 0x040000bc: case 0x040000bd: case 0x040000be: case 0x040000bf:
@@ -716,16 +758,16 @@ void Bus::writeIO8(uint32_t address, uint8_t value)
 		return;
 	case 0x04000100: case 0x04000101: case 0x04000102: case 0x04000103: case 0x04000104: case 0x04000105: case 0x04000106: case 0x04000107:
 	case 0x04000108: case 0x04000109: case 0x0400010a: case 0x0400010b: case 0x0400010c: case 0x0400010d: case 0x0400010e: case 0x0400010f:
-		m_timer->writeIO(address, value);
+		m_timer.writeIO(address, value);
 		return;
 	case 0x04000130: case 0x04000131: case 0x04000132: case 0x04000133:
-		m_input->writeIORegister(address, value);
+		m_input.writeIORegister(address, value);
 		return;
 	case 0x04000200: case 0x04000201: case 0x04000202: case 0x04000203: case 0x04000208: case 0x04000209: case 0x0400020A: case 0x0400020B:
-		m_interruptManager->writeIO(address,value);
+		m_interruptManager.writeIO(address,value);
 		return;
 	case 0x04000120: case 0x04000121: case 0x04000122: case 0x04000123: case 0x0400012A: case 0x04000128: case 0x04000129:
-		m_serial->writeIO(address, value);
+		m_serial.writeIO(address, value);
 		break;
 	case 0x04000204:
 		WAITCNT &= 0xFF00; WAITCNT |= value;
@@ -742,7 +784,7 @@ void Bus::writeIO8(uint32_t address, uint8_t value)
 		SRAMCycles = nonseqLUT[(WAITCNT & 0b11)];
 		if (prefetchEnabled && prefetchInProgress && !(((WAITCNT >> 14) & 0b1)))
 		{
-			m_scheduler->addCycles((prefetchTargetCycles - prefetchInternalCycles));
+			m_scheduler.addCycles((prefetchTargetCycles - prefetchInternalCycles));
 			prefetchSize++;
 		}
 		prefetchEnabled = ((WAITCNT >> 14) & 0b1);
@@ -836,15 +878,14 @@ void Bus::haltSystem(bool stop)
 {
 	if (stop)	//TODO: research this on real hardware. (e.g. if IF gets set if KEYCNT.14 not enabled??)
 	{
-		m_ppu->reset();	//display disabled on real hardware, so set screen to all black
+		m_ppu.reset();	//display disabled on real hardware, so set screen to all black
 		Logger::getInstance()->msg(LoggerSeverity::Info, "STOP mode entered. ");
-		while (!m_input->getIRQConditionsMet() && !Config::GBA.shouldReset)	//<-- potentially game pak or SIO irq could exit stop
-			m_input->tick();												//but fwiw games only really use stop for 'sleep mode', exited thru the joypad
+		m_input.waitForWakeup();		//sleeps the emu thread on the keypad, rather than spinning
 		return;
 	}
-	m_scheduler->addCycles(2);	//2 cycle penalty (one before, one after?) when haltcnt written
-	while (!m_interruptManager->getInterrupt() && !Config::GBA.shouldReset)
-		m_scheduler->jumpToNextEvent();			//teleport to next event(s) until interrupt fires
+	m_scheduler.addCycles(2);	//2 cycle penalty (one before, one after?) when haltcnt written
+	while (!m_interruptManager.getInterrupt() && !Config::GBA.shouldReset)
+		m_scheduler.jumpToNextEvent();			//teleport to next event(s) until interrupt fires
 }
 
 void Bus::tickPrefetcher(uint64_t cycles)
@@ -880,3 +921,30 @@ void Bus::invalidatePrefetchBuffer()
 	prefetchInternalCycles = 0;
 	prefetchShouldDelay = false;
 }
+
+void Bus::tickCartAccess(uint32_t address, AccessType accessType)
+{
+	//same timing as a non-prefetch 16 bit access to cart space in read16/write16, without touching the device
+	uint8_t page = (address >> 24) & 0xFF;
+	dmaNonsequentialAccess = false;
+	int cartCycles = ((accessType == AccessType::Sequential) && ((address & 0x1FF) != 0)) ? waitstateSequentialTable[((page - 8) >> 1)] : waitstateNonsequentialTable[((page - 8) >> 1)];
+	m_scheduler.addCycles(cartCycles);
+	if (prefetchInProgress && prefetchShouldDelay)
+		m_scheduler.addCycles(1);
+	prefetchShouldDelay = false;
+	invalidatePrefetchBuffer();
+}
+
+//the cpu and dma pick one of these at compile time - only the debug run loop's instantiation looks at watchpoints
+template uint8_t Bus::read8<false>(uint32_t address, AccessType accessType);
+template uint8_t Bus::read8<true>(uint32_t address, AccessType accessType);
+template void Bus::write8<false>(uint32_t address, uint8_t value, AccessType accessType);
+template void Bus::write8<true>(uint32_t address, uint8_t value, AccessType accessType);
+template uint16_t Bus::read16<false>(uint32_t address, AccessType accessType);
+template uint16_t Bus::read16<true>(uint32_t address, AccessType accessType);
+template void Bus::write16<false>(uint32_t address, uint16_t value, AccessType accessType);
+template void Bus::write16<true>(uint32_t address, uint16_t value, AccessType accessType);
+template uint32_t Bus::read32<false>(uint32_t address, AccessType accessType);
+template uint32_t Bus::read32<true>(uint32_t address, AccessType accessType);
+template void Bus::write32<false>(uint32_t address, uint32_t value, AccessType accessType);
+template void Bus::write32<true>(uint32_t address, uint32_t value, AccessType accessType);
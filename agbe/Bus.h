@@ -13,8 +13,10 @@
 #include"APU.h"
 #include"SerialStub.h"
 #include"GPIO_RTC.h"
+#include"Debugger.h"
 
 #include<iostream>
+#include<variant>
 
 struct DMAChannel
 {
@@ -47,17 +49,18 @@ enum class AccessType
 class Bus
 {
 public:
-	Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<PPU> ppu, std::shared_ptr<Input> input, std::shared_ptr<Scheduler> scheduler);
+	Bus(std::vector<uint8_t> BIOS, std::vector<uint8_t> cartData, GBAMem& mem, InterruptManager& interruptManager, PPU& ppu, Input& input, Scheduler& scheduler, Debugger& debugger);
 	~Bus();
 
-	uint8_t read8(uint32_t address, AccessType accessType);
-	void write8(uint32_t address, uint8_t value, AccessType accessType);
+	//debug=true checks data watchpoints, and is only used from the debug run loop. opcode fetches never check them
+	template<bool debug = false> uint8_t read8(uint32_t address, AccessType accessType);
+	template<bool debug = false> void write8(uint32_t address, uint8_t value, AccessType accessType);
 
-	uint16_t read16(uint32_t address, AccessType accessType);
-	void write16(uint32_t address, uint16_t value, AccessType accessType);
+	template<bool debug = false> uint16_t read16(uint32_t address, AccessType accessType);
+	template<bool debug = false> void write16(uint32_t address, uint16_t value, AccessType accessType);
 
-	uint32_t read32(uint32_t address, AccessType accessType);
-	void write32(uint32_t address, uint32_t value, AccessType accessType);
+	template<bool debug = false> uint32_t read32(uint32_t address, AccessType accessType);
+	template<bool debug = false> void write32(uint32_t address, uint32_t value, AccessType accessType);
 
 	uint32_t fetch32(uint32_t address, AccessType accessType);
 	uint16_t fetch16(uint32_t address, AccessType accessType);
@@ -82,20 +85,26 @@ public:
 
 	void tickPrefetcher(uint64_t cycles);
 	void invalidatePrefetchBuffer();
+	void tickCartAccess(uint32_t address, AccessType accessType);
 
 	void setBusLocked(bool lock) { busLocked = lock; }
+	void commitBackupMemory();
+	bool getAudioPacingEmulation() { return m_apu.getPacingEmulation(); }
 private:
-	std::shared_ptr<Scheduler> m_scheduler;
-	std::shared_ptr<GBAMem> m_mem;
-	std::shared_ptr<InterruptManager> m_interruptManager;
-	std::shared_ptr<PPU> m_ppu;
-	std::shared_ptr<Input> m_input;
-	std::shared_ptr<Timer> m_timer;
-	std::shared_ptr<APU> m_apu;
-	std::shared_ptr<SerialStub> m_serial;
-	std::shared_ptr<RTC> m_rtc;
-
-	std::shared_ptr<BackupBase> m_backupMemory;
+	Scheduler& m_scheduler;
+	GBAMem& m_mem;
+	InterruptManager& m_interruptManager;
+	PPU& m_ppu;
+	Input& m_input;
+	Debugger& m_debugger;
+
+	//peripherals only the bus talks to live inside it
+	Timer m_timer;
+	APU m_apu;
+	SerialStub m_serial;
+	RTC m_rtc;
+
+	std::variant<std::monostate, SRAM, Flash, EEPROM> m_backupMemory;	//held by value so cart accesses are direct calls, not virtual ones
 	BackupType m_backupType = BackupType::None;
 	bool backupInitialised = false;	//<--this might be bad, but necessary for EEPROM detection bc we use DMA
 
@@ -129,7 +138,7 @@ private:
 	uint8_t DMARegRead(uint32_t address);
 	void DMARegWrite(uint32_t address, uint8_t value);
 	void checkDMAChannel(int idx);
-	void doDMATransfer(int channel);
+	template<bool debug> void doDMATransfer(int channel);
 	void scheduleDMA(int channel);
 	void checkRequestedDMAs();
 	void onVBlank();
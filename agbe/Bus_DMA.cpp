@@ -231,21 +231,21 @@ void Bus::checkDMAChannel(int idx)
 		if (startTiming == 0)
 		{
 			channelEnableMask |= (1 << idx);
-			m_scheduler->addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler->getCurrentTimestamp() + 3);
-			m_scheduler->forceSync(3);	//i don't think 3 cycles is correct for immediate dma...
+			m_scheduler.addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler.getCurrentTimestamp() + 3);
+			m_scheduler.forceSync(3);	//i don't think 3 cycles is correct for immediate dma...
 		}
 	}
 }
 
-void Bus::doDMATransfer(int channel)
+template<bool debug> void Bus::doDMATransfer(int channel)
 {
 	if (busLocked)
 	{
 		Logger::getInstance()->msg(LoggerSeverity::Warn, "DMA start attempt while bus was locked. This codepath isn't fully tested..!!!");
 		//reschedule this dma and try again in a cycle
 		channelEnableMask |= (1 << channel);
-		m_scheduler->addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler->getCurrentTimestamp() + 1);
-		m_scheduler->forceSync(1);	
+		m_scheduler.addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler.getCurrentTimestamp() + 1);
+		m_scheduler.forceSync(1);	
 		return;
 	}
 	m_openBusVals.dmaJustFinished = false;
@@ -261,7 +261,7 @@ void Bus::doDMATransfer(int channel)
 
 	bool dmaWasInProgress = dmaInProgress;
 	if(!dmaWasInProgress)
-		m_scheduler->addCycles(1);	//2 cycle startup delay?
+		m_scheduler.addCycles(1);	//2 cycle startup delay?
 	//we assume the transfer is going to take place by the time this function is called
 	DMAChannel curChannel = m_dmaChannels[channel];
 
@@ -297,7 +297,7 @@ void Bus::doDMATransfer(int channel)
 		}
 		else
 			Logger::getInstance()->msg(LoggerSeverity::Info, "Auto-detected 4K EEPROM chip access!!");
-		m_backupMemory = std::make_shared<EEPROM>(m_backupType);
+		m_backupMemory.emplace<EEPROM>(m_backupType);
 	}
 
 	uint8_t srcAddrCtrl = ((curChannel.control >> 7) & 0b11);
@@ -322,9 +322,35 @@ void Bus::doDMATransfer(int channel)
 		curChannel.control |= 0x200;
 	}
 
+	//eeprom commands are sent one bit per halfword by dma3. if this transfer is a whole command, then the bits are packed up and handed to the eeprom
+	//in one go. cart timing is still ticked per halfword so the transfer takes exactly as long as the bit-serial path.
+	//the eeprom side never goes through the bus though, so with watchpoints armed it's left to the normal path
+	EEPROM* eepromTarget = nullptr;
+	bool eepromWrite = false;
+	uint8_t eepromBits[81];
+	bool watching = debug && m_debugger.getWatchpointsArmed();
+	if (channel == 3 && !wordTransfer && numWords <= 81 && srcAddrCtrl != 1 && dstAddrCtrl != 1 && !watching)
+	{
+		auto isRAM = [](uint32_t addr) { uint8_t page = (addr >> 24) & 0xFF; return page >= 2 && page <= 7; };
+		auto isEEPROM = [numWords](uint32_t addr) { return ((addr >> 24) == 0xD) && (((addr + numWords * 2) >> 24) == 0xD); };
+		if (EEPROM* eeprom = std::get_if<EEPROM>(&m_backupMemory))
+		{
+			if (isEEPROM(dest) && isRAM(src) && isRAM(src + numWords * 2))
+			{
+				eepromTarget = eeprom;
+				eepromWrite = true;
+			}
+			else if (isEEPROM(src) && isRAM(dest) && isRAM(dest + numWords * 2))
+			{
+				eepromTarget = eeprom;
+				eepromTarget->readBits(eepromBits, numWords);
+			}
+		}
+	}
+
 	for (int i = 0; i < numWords; i++)		
 	{
-		m_scheduler->addCycles(2);
+		m_scheduler.addCycles(2);
 		if (wordTransfer)
 		{
 			uint32_t word = 0;
@@ -332,10 +358,27 @@ void Bus::doDMATransfer(int channel)
 				word = m_openBusVals.dma[channel];
 			else
 			{
-				word = read32(src&~0b11, (AccessType)!dmaNonsequentialAccess);
+				word = read32<debug>(src&~0b11, (AccessType)!dmaNonsequentialAccess);
 				m_openBusVals.dma[channel] = word;
 			}
-			write32(dest&~0b11, word,(AccessType)!dmaNonsequentialAccess);									
+			write32<debug>(dest&~0b11, word,(AccessType)!dmaNonsequentialAccess);									
+		}
+		else if (eepromTarget)
+		{
+			uint16_t halfword = 0;
+			if (eepromWrite)
+			{
+				halfword = read16<debug>(src & ~0b1, (AccessType)!dmaNonsequentialAccess);
+				eepromBits[i] = halfword & 0b1;
+				tickCartAccess(dest & ~0b1, (AccessType)!dmaNonsequentialAccess);
+			}
+			else
+			{
+				tickCartAccess(src & ~0b1, (AccessType)!dmaNonsequentialAccess);
+				halfword = eepromBits[i];
+				write16<debug>(dest & ~0b1, halfword, (AccessType)!dmaNonsequentialAccess);
+			}
+			m_openBusVals.dma[channel] = (halfword << 16) | halfword;
 		}
 		else
 		{
@@ -344,12 +387,12 @@ void Bus::doDMATransfer(int channel)
 				halfword = std::rotr(m_openBusVals.dma[channel],8*(dest&0b11));
 			else
 			{
-				halfword = read16(src&~0b1, (AccessType)!dmaNonsequentialAccess);
+				halfword = read16<debug>(src&~0b1, (AccessType)!dmaNonsequentialAccess);
 				m_openBusVals.dma[channel] = (halfword << 16) | halfword;
 			}
-			write16(dest&~0b1, halfword,(AccessType)!dmaNonsequentialAccess);                        			
+			write16<debug>(dest&~0b1, halfword,(AccessType)!dmaNonsequentialAccess);                        			
 		}
-		m_scheduler->tick();
+		m_scheduler.tick();
 		int incrementAmount = (wordTransfer) ? 4 : 2;
 
 		switch (srcAddrCtrl)
@@ -379,6 +422,9 @@ void Bus::doDMATransfer(int channel)
 		}
 
 	}
+	if (eepromTarget && eepromWrite)
+		eepromTarget->writeBits(eepromBits, numWords);
+
 	m_dmaChannels[channel].internalSrc = src;
 	m_dmaChannels[channel].internalDest = dest;
 	m_dmaChannels[channel].internalWordCount = 0;
@@ -386,7 +432,7 @@ void Bus::doDMATransfer(int channel)
 	if (((curChannel.control >> 14) & 0b1))
 	{
 		constexpr InterruptType interruptLUT[4] = { InterruptType::DMA0,InterruptType::DMA1,InterruptType::DMA2,InterruptType::DMA3 };
-		m_interruptManager->requestInterrupt(interruptLUT[channel]);
+		m_interruptManager.requestInterrupt(interruptLUT[channel]);
 	}
 
 	bool repeatDMA = ((curChannel.control >> 9) & 0b1);
@@ -403,7 +449,7 @@ void Bus::doDMATransfer(int channel)
 	if (!dmaWasInProgress)
 	{
 		dmaInProgress = false;
-		m_scheduler->addCycles(1);
+		m_scheduler.addCycles(1);
 		m_openBusVals.dmaJustFinished = true;
 		m_openBusVals.lastDmaVal = m_openBusVals.dma[channel];
 	}
@@ -421,7 +467,10 @@ void Bus::checkRequestedDMAs()
 	{
 		int dmaIdx = lowestDMALUT[channelEnableMask];
 		channelEnableMask &= ~(1 << dmaIdx);
-		doDMATransfer(dmaIdx);
+		if (m_debugger.getEnabled())		//once per transfer, so only a debugging session's dmas look at watchpoints
+			doDMATransfer<true>(dmaIdx);
+		else
+			doDMATransfer<false>(dmaIdx);
 	}
 }
 
@@ -461,7 +510,7 @@ void Bus::onVideoCapture()	//special video capture dma used by dma3 (scanlines 2
 		uint8_t startTiming = ((curCtrlReg >> 12) & 0b11);
 		if (startTiming == 3)
 		{
-			if (m_ppu->getVCOUNT() == 161)						//clear repeat bit if on the last scanline of dma
+			if (m_ppu.getVCOUNT() == 161)						//clear repeat bit if on the last scanline of dma
 				m_dmaChannels[3].control &= 0x7FFF;
 			scheduleDMA(3);
 		}
@@ -487,7 +536,7 @@ void Bus::onAudioFIFO(int channel)
 void Bus::scheduleDMA(int channel)
 {
 	channelEnableMask |= (1 << channel);
-	m_scheduler->addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler->getEventTime() + 2);
+	m_scheduler.addEvent(Event::DMA, &Bus::DMA_CheckCallback, (void*)this, m_scheduler.getEventTime() + 2);
 }
 
 void Bus::DMA_CheckCallback(void* context)
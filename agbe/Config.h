@@ -2,13 +2,44 @@
 
 #include<iostream>
 
+enum class AudioSinkType
+{
+	Device,
+	Null,			//no audio at all - the apu skips mixing
+	WAVFile,
+	RawFile,		//signed 16 bit stereo pcm
+	Pipe			//same as raw, but flushed as it's mixed
+};
+
+enum class FastForwardAudio
+{
+	Mute,
+	Drop,			//play one block in every n, so pitch stays the same but it skips
+	Resample		//play everything, sped up or slowed down - pitch follows the speed
+};
+
 struct SystemConfig
 {
 	std::string exePath;
 	std::string RomName;
 	bool shouldReset;
-	bool disableVideoSync;
+	bool disableVideoSync;				//run uncapped
+	float speedMultiplier = 1.0f;		//target speed when paced, 0.25x-16x
+	FastForwardAudio fastForwardAudio = FastForwardAudio::Drop;	//what the audio device gets when not running at 1x. file sinks always get everything
+	bool logFramePacing = false;		//log a frame time jitter histogram every 600 paced frames
+	AudioSinkType audioSink = AudioSinkType::Device;	//takes effect on reset
+	std::string audioOutputPath;		//for the file/pipe sinks
+	int audioSampleRate = 48000;		//host output rate, takes effect on reset
+	bool audioSync = true;				//pace emulation off the audio device draining samples. otherwise the host clock paces it, and audio drops/pads as needed
+	bool threadedRenderer = false;		//render scanlines on a separate thread. takes effect on reset
+	int frameSkip = 0;					//frames skipped after each rendered one. emulation/timing is unaffected, only pixel work is skipped
+	bool noVideo = false;				//skip rendering entirely (headless)
+	int saveFlushInterval = 1000;	//ms between background writes of modified save data
 	double fps = 0;
+	double achievedSpeed = 0;		//measured emulation speed, 1.0 = real time
+	double lineReusePercent = 0;	//% of lines last frame that were unchanged from the previous frame, so weren't re-rendered
+	uint64_t audioOverruns = 0;		//frames dropped because the audio ring was full
+	uint64_t audioUnderruns = 0;	//frames of silence played because the audio ring ran dry
 };
 
 class Config
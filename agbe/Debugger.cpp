@@ -0,0 +1,167 @@
+#include"Debugger.h"
+
+#include<cstring>
+
+Debugger::Debugger()
+{
+	m_publishedWatches = std::make_shared<WatchSnapshot>();
+	m_activeWatches = m_publishedWatches;
+}
+
+Debugger::~Debugger()
+{
+
+}
+
+void Debugger::addBreakpoint(uint32_t address)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_breakpoints.insert(address);
+	updateState();
+}
+
+void Debugger::removeBreakpoint(uint32_t address)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_breakpoints.erase(address);
+	updateState();
+}
+
+void Debugger::addWatchpoint(uint32_t start, uint32_t end, WatchType type)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (end < start)
+		std::swap(start, end);
+	m_watchpoints.push_back({ start, end, type });
+	publishWatchpoints();
+	updateState();
+}
+
+void Debugger::removeWatchpoint(uint32_t start, uint32_t end)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	std::erase_if(m_watchpoints, [start, end](const Watchpoint& w) { return w.start == start && w.end == end; });
+	publishWatchpoints();
+	updateState();
+}
+
+void Debugger::clearAll()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_breakpoints.clear();
+	m_watchpoints.clear();
+	m_paused = false;
+	m_stepRequested = false;
+	publishWatchpoints();
+	updateState();
+	m_resumeCondition.notify_one();
+}
+
+void Debugger::pause()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_paused = true;
+	updateState();
+}
+
+void Debugger::resume()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_paused)
+		m_skipBreakpoint = true;
+	m_paused = false;
+	updateState();
+	m_resumeCondition.notify_one();
+}
+
+void Debugger::step()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stepRequested = true;
+	m_paused = true;
+	updateState();
+	m_resumeCondition.notify_one();
+}
+
+bool Debugger::shouldBreak(uint32_t pc)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_activeWatches = m_publishedWatches;		//pick up any watchpoint changes before the next instruction's accesses
+	if (m_stepRequested)
+	{
+		m_stepRequested = false;	//run exactly one instruction, we stay paused so the next call breaks again
+		m_skipBreakpoint = false;
+		return false;
+	}
+	if (m_paused)
+		return true;
+
+	bool skip = m_skipBreakpoint;
+	m_skipBreakpoint = false;
+	if (!skip && m_breakpoints.contains(pc))
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Info, std::format("Breakpoint hit at {:#x}", pc));
+		m_paused = true;
+		updateState();
+		return true;
+	}
+	return false;
+}
+
+void Debugger::waitWhilePaused()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	while (m_paused && !m_stepRequested && !Config::GBA.shouldReset)		//shouldReset isn't signalled, so poll for it
+		m_resumeCondition.wait_for(lock, std::chrono::milliseconds(10));
+}
+
+void Debugger::checkWatchpoint(uint32_t address, int size, bool write)
+{
+	//only the emu thread touches m_activeWatches, so no lock until something actually hits
+	WatchType accessType = (write) ? WatchType::Write : WatchType::Read;
+	uint32_t lastByte = address + size - 1;
+	for (auto& w : m_activeWatches->watchpoints)
+	{
+		if (!((int)w.type & (int)accessType))
+			continue;
+		if (lastByte < w.start || address > w.end)
+			continue;
+
+		//the access still completes - we break before the next instruction
+		Logger::getInstance()->msg(LoggerSeverity::Info, std::format("Watchpoint hit: {} {:#x} (size {})", (write) ? "write to" : "read from", address, size));
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_paused = true;
+		updateState();
+		return;
+	}
+}
+
+void Debugger::publishWatchpoints()
+{
+	//m_lock must be held. a fresh snapshot each time - the emu thread may still be reading the old one
+	auto snapshot = std::make_shared<WatchSnapshot>();
+	snapshot->watchpoints = m_watchpoints;
+	constexpr uint32_t numPages = 1 << (28 - WatchSnapshot::pageShift);
+	for (auto& w : m_watchpoints)
+	{
+		uint32_t firstPage = w.start >> WatchSnapshot::pageShift;
+		uint32_t lastPage = w.end >> WatchSnapshot::pageShift;
+		if ((lastPage - firstPage) >= numPages)		//big enough to cover every page
+		{
+			memset(snapshot->pages, 0xFF, sizeof(snapshot->pages));
+			break;
+		}
+		for (uint32_t page = firstPage; page != (lastPage + 1); page++)
+		{
+			uint32_t wrapped = page & (numPages - 1);		//bus addresses are looked up with the top nibble masked off, same here
+			snapshot->pages[wrapped >> 6] |= (1ULL << (wrapped & 63));
+		}
+	}
+	m_publishedWatches = snapshot;
+}
+
+void Debugger::updateState()
+{
+	//m_lock must be held
+	m_enabled.store(m_paused || m_stepRequested || m_breakpoints.size() || m_watchpoints.size(), std::memory_order_relaxed);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include"Logger.h"
+#include"Config.h"
+
+#include<set>
+#include<vector>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<chrono>
+#include<memory>
+
+enum class WatchType
+{
+	Read=1,
+	Write=2,
+	ReadWrite=3
+};
+
+struct Watchpoint
+{
+	uint32_t start;
+	uint32_t end;		//inclusive
+	WatchType type;
+};
+
+//what the emu thread checks accesses against. built by the frontend under the lock and never modified after, so the emu thread can
+//read it without taking the lock
+struct WatchSnapshot
+{
+	static constexpr int pageShift = 12;						//4KB pages, over the 28 bit bus address space
+	uint64_t pages[(1 << (28 - pageShift)) / 64] = {};			//bit per page with a watchpoint in it
+	std::vector<Watchpoint> watchpoints;
+};
+
+//breakpoints/watchpoints/stepping. the frontend calls the public functions from its own thread, the emu thread only ever
+//looks at this when getEnabled() is set - the normal run loop and its bus accesses don't check anything
+class Debugger
+{
+public:
+	Debugger();
+	~Debugger();
+
+	void addBreakpoint(uint32_t address);
+	void removeBreakpoint(uint32_t address);
+	void addWatchpoint(uint32_t start, uint32_t end, WatchType type);
+	void removeWatchpoint(uint32_t start, uint32_t end);
+	void clearAll();
+
+	void pause();
+	void resume();
+	void step();
+	bool getPaused() { std::lock_guard<std::mutex> lock(m_lock); return m_paused; }
+
+	//emu thread side
+	bool getEnabled() { return m_enabled.load(std::memory_order_relaxed); }
+	bool getWatchpointsArmed() { return !m_activeWatches->watchpoints.empty(); }
+	inline bool getPageWatched(uint32_t address)
+	{
+		uint32_t page = (address & 0x0FFFFFFF) >> WatchSnapshot::pageShift;
+		return (m_activeWatches->pages[page >> 6] >> (page & 63)) & 0b1;
+	}
+	bool shouldBreak(uint32_t pc);
+	void waitWhilePaused();
+	void checkWatchpoint(uint32_t address, int size, bool write);
+private:
+	void updateState();
+	void publishWatchpoints();
+
+	std::mutex m_lock;
+	std::condition_variable m_resumeCondition;
+	std::set<uint32_t> m_breakpoints;
+	std::vector<Watchpoint> m_watchpoints;
+
+	std::shared_ptr<const WatchSnapshot> m_publishedWatches;	//latest from the frontend, under m_lock
+	std::shared_ptr<const WatchSnapshot> m_activeWatches;		//emu thread's copy, picked up in shouldBreak()
+
+	std::atomic<bool> m_enabled = false;
+	bool m_paused = false;
+	bool m_stepRequested = false;
+	bool m_skipBreakpoint = false;				//so continuing from a breakpoint doesn't immediately hit it again
+};
@@ -112,7 +112,11 @@ void Display::draw()
 {
 	glfwPollEvents();
 
-	std::string title = std::to_string(Config::GBA.fps);
+	std::string speed = Config::GBA.disableVideoSync ? std::format("{:.0f}% uncapped", Config::GBA.achievedSpeed * 100.0)
+		: std::format("{:.0f}% of {:.0f}%", Config::GBA.achievedSpeed * 100.0, Config::GBA.speedMultiplier * 100.0);
+	std::string title = std::format("{:.2f} fps ({}) - {:.0f}% lines reused", Config::GBA.fps, speed, Config::GBA.lineReusePercent);
+	if (Config::GBA.audioOverruns || Config::GBA.audioUnderruns)		//only worth showing once audio's actually glitched
+		title += std::format(" - audio {} dropped/{} padded", Config::GBA.audioOverruns, Config::GBA.audioUnderruns);
 	glfwSetWindowTitle(m_window, title.c_str());
 
 	GuiRenderer::prepareFrame();
@@ -129,7 +133,7 @@ void Display::draw()
 	glfwSwapBuffers(m_window);
 }
 
-void Display::update(void* data)
+void Display::update(const void* data)
 {
 	glBindTexture(GL_TEXTURE_2D, m_texHandle);
 	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 240, 160, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, data);
@@ -37,7 +37,7 @@ public:
 
 	bool getShouldClose();
 	void draw();
-	void update(void* newData);	//unsafe but size is known :)
+	void update(const void* newData);	//unsafe but size is known :)
 
 	bool getPressed(unsigned int key);
 	void registerDragDropCallback(GLFWdropfun callbackFn);
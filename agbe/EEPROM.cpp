@@ -14,7 +14,8 @@ EEPROM::EEPROM(BackupType type)
 	saveSize = (type == BackupType::EEPROM4K) ? 64 : 1024; //word count, where a word=8 bytes.
 
 	std::vector<uint8_t> saveData;
-	if (getSaveData(saveData))
+	bool saveValid = getSaveData(saveData) && (saveData.size() >= (size_t)(saveSize * 8));
+	if (saveValid)
 	{
 		for (int i = 0; i < saveSize; i++)
 		{
@@ -30,25 +31,23 @@ EEPROM::EEPROM(BackupType type)
 	}
 	else
 		memset(ROMData, 0xFF, 1024 * 8);
+
+	startSaveFlush(saveSize * 8, saveValid);
 }
 
 EEPROM::~EEPROM()
 {
-	//first have to prepare save data
-	uint8_t* tempSaveData = new uint8_t[saveSize * 8];
+	stopSaveFlush();
+}
 
-	for (int i = 0; i < saveSize; i++)
+void EEPROM::readSaveBytes(uint32_t offset, uint8_t* out, int size)
+{
+	for (int i = 0; i < size; i++)
 	{
-		uint64_t curVal = ROMData[i];
-		for (int j = 0; j < 8; j++)
-		{
-			uint8_t writeVal = (curVal >> ((7-j) * 8));
-			tempSaveData[(i * 8) + j] = writeVal;	//write out each 8 byte value in big endian order
-		}
+		uint32_t byteIdx = offset + i;
+		uint64_t curVal = ROMData[byteIdx >> 3];
+		out[i] = (curVal >> ((7 - (byteIdx & 7)) * 8));	//each 8 byte value is written out in big endian order
 	}
-
-	writeSaveData((void*)tempSaveData, saveSize*8);
-	delete[] tempSaveData;
 }
 
 uint8_t EEPROM::read(uint32_t address)
@@ -130,8 +129,11 @@ void EEPROM::write(uint32_t address, uint8_t value)
 				newROMData |=  ((uint64_t)value << (63-(writeCount - 1)));
 			if (writeCount == 65)
 			{
-				if(writeAddress<=1023)
+				if (writeAddress <= 1023)
+				{
 					ROMData[writeAddress] = newROMData;
+					markDirty(writeAddress * 8, 8);
+				}
 				state = WriteState::RequestType;
 				tempWriteBits = 0;
 				newROMData = 0;
@@ -141,4 +143,65 @@ void EEPROM::write(uint32_t address, uint8_t value)
 		}
 		break;
 	}
+}
+
+void EEPROM::readBits(uint8_t* bits, int count)
+{
+	//only shortcut a full readback (4 dummy bits + 64 data bits) - anything else goes through the bit-serial path
+	if (count != 68 || !isReading || !activeRead || readbackCount != 0)
+	{
+		for (int i = 0; i < count; i++)
+			bits[i] = read(0);
+		return;
+	}
+
+	for (int i = 0; i < 4; i++)
+		bits[i] = 1;
+	for (int i = 0; i < 64; i++)
+		bits[4 + i] = (readData >> (63 - i)) & 0b1;
+
+	readData = 0;
+	readbackCount = 0;
+	activeRead = false;
+}
+
+void EEPROM::writeBits(const uint8_t* bits, int count)
+{
+	//read request: 2 bit type, address, 1 stop bit. write request: 2 bit type, address, 64 bits data, 1 stop bit
+	bool readRequest = (bits[0] & bits[1] & 0b1);
+	int expectedLength = 2 + addressSize + ((readRequest) ? 1 : 65);
+	if (count != expectedLength || state != WriteState::RequestType || writeCount != 0)
+	{
+		for (int i = 0; i < count; i++)
+			write(0, bits[i]);
+		return;
+	}
+
+	uint32_t address = 0;
+	for (int i = 0; i < addressSize; i++)
+		address = (address << 1) | (bits[2 + i] & 0b1);
+
+	isReading = readRequest;
+	if (isReading)
+	{
+		if (address > 1023)
+			readData = 0xFFFFFFFFFFFFFFFF;	//out of bounds read returns all 1s
+		else
+			readData = ROMData[address];
+		activeRead = true;
+		readbackCount = 0;
+	}
+	else
+	{
+		uint64_t data = 0;
+		for (int i = 0; i < 64; i++)
+			data = (data << 1) | (bits[2 + addressSize + i] & 0b1);
+		if (address <= 1023)
+		{
+			ROMData[address] = data;
+			markDirty(address * 8, 8);
+		}
+	}
+
+	tempWriteBits = 0;	//leave the state machine exactly how the bit-serial path would
 }
\ No newline at end of file
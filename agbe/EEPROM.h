@@ -11,7 +11,7 @@ enum class WriteState
 	Data
 };
 
-class EEPROM : public BackupBase
+class EEPROM final : public BackupBase
 {
 public:
 	EEPROM(BackupType type);
@@ -20,6 +20,10 @@ public:
 	//data width wouldn't matter bc we only care about the least significant bit of whatever's being sent
 	uint8_t read(uint32_t address);
 	void write(uint32_t address, uint8_t value);
+
+	//packed versions of the above for when dma moves a whole command in one transfer (one bit per entry)
+	void readBits(uint8_t* bits, int count);
+	void writeBits(const uint8_t* bits, int count);
 private:
 	uint64_t ROMData[1024];
 	
@@ -36,4 +40,6 @@ private:
 	bool activeRead = false;
 	WriteState state = {};
 
+	void readSaveBytes(uint32_t offset, uint8_t* out, int size);
+
 };
\ No newline at end of file
@@ -8,13 +8,11 @@ Flash::Flash(BackupType type)
 
 	saveSize = (type == BackupType::FLASH1M) ? (128 * 1024) : (64 * 1024);
 	std::vector<uint8_t> saveData;
-
+	memset(flashMem, 0xFF, 131072);
 	if (getSaveData(saveData))
 	{
-		memcpy(flashMem, (void*)&saveData[0], saveSize);
+		memcpy(flashMem, saveData.data(), (std::min)(saveData.size(), (size_t)saveSize));
 	}
-	else
-		memset(flashMem, 0xFF, 131072);
 
 	switch (type)
 	{
@@ -27,11 +25,13 @@ Flash::Flash(BackupType type)
 		m_deviceID = 0x1B;
 		break;
 	}
+
+	startSaveFlush(saveSize, saveData.size() >= (size_t)saveSize);
 }
 
 Flash::~Flash()
 {
-	writeSaveData(flashMem, saveSize);
+	stopSaveFlush();
 }
 
 uint8_t Flash::read(uint32_t address)
@@ -74,6 +74,7 @@ void Flash::write(uint32_t address, uint8_t value)
 				break;
 			case 0x10:			
 				memset(flashMem, 0xFF, 65536 * 2);
+				markDirty(0, 65536 * 2);
 				m_state = FlashState::Ready;
 				break;
 			case 0xA0:
@@ -102,6 +103,7 @@ void Flash::write(uint32_t address, uint8_t value)
 		int baseAddr = (address & 0xF000);
 		for (int i = 0; i < 0x1000; i++)
 			flashMem[(bank*65536) + (baseAddr + i)] = 0xFF;
+		markDirty((bank * 65536) + baseAddr, 0x1000);
 
 		m_state = FlashState::Ready;
 	}
@@ -110,6 +112,7 @@ void Flash::write(uint32_t address, uint8_t value)
 	if (m_state == FlashState::PrepareWrite && !noWrite)
 	{
 		flashMem[(bank * 65536) + address] = value;
+		markDirty((bank * 65536) + address);
 		m_state = FlashState::Ready;
 	}
 
@@ -119,4 +122,9 @@ void Flash::write(uint32_t address, uint8_t value)
 		bank = value & 0b1;
 		m_state = FlashState::Ready;
 	}
+}
+
+void Flash::readSaveBytes(uint32_t offset, uint8_t* out, int size)
+{
+	memcpy(out, flashMem + offset, size);
 }
\ No newline at end of file
@@ -13,7 +13,7 @@ enum class FlashState
 	BankSwitch					//set after 'B0' write to E005555 in 'Operation' mode - 1 bit bank number about to be written to E000000
 };
 
-class Flash : public BackupBase
+class Flash final : public BackupBase
 {
 public:
 	Flash(BackupType type);
@@ -27,4 +27,6 @@ private:
 	uint8_t flashMem[128 * 1024];
 	uint8_t bank = 0;
 	FlashState m_state;
+
+	void readSaveBytes(uint32_t offset, uint8_t* out, int size);
 };
\ No newline at end of file
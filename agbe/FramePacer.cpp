@@ -0,0 +1,145 @@
+#include"FramePacer.h"
+
+#include<Windows.h>
+
+FramePacer::FramePacer()
+{
+	//windows sleeps in ~15.6ms ticks by default. sdl bumps that to 1ms when it has a device open, but headless/file sink setups need it too
+	TIMECAPS caps = {};
+	if (timeGetDevCaps(&caps, sizeof(caps)) == MMSYSERR_NOERROR)
+		m_timerPeriod = (std::max)(caps.wPeriodMin, (UINT)1);
+	if (timeBeginPeriod(m_timerPeriod) != TIMERR_NOERROR)
+		m_timerPeriod = 0;
+	reset();
+}
+
+FramePacer::~FramePacer()
+{
+	if (m_timerPeriod)
+		timeEndPeriod(m_timerPeriod);
+}
+
+void FramePacer::reset()
+{
+	clock::time_point now = clock::now();
+	m_lastFrameEnd = now;
+	m_speedMeasureStart = now;
+	m_speedMeasureFrames = 0;
+	resync(now);
+}
+
+void FramePacer::endFrame(bool paced, double speed)
+{
+	if (speed != m_speed)
+	{
+		//new speed takes effect from the last frame boundary rather than stretching the whole history
+		m_speed = speed;
+		resync(m_lastFrameEnd);
+	}
+
+	if (paced)
+	{
+		if (clock::now() - m_deadline > std::chrono::nanoseconds((int64_t)(frameNanoseconds * maxFramesBehind / m_speed)))
+			resync(clock::now());		//debugger pause, host hiccup etc. - don't run flat out to make the time back
+		else
+			waitUntil(m_deadline);
+	}
+
+	clock::time_point now = clock::now();
+	int64_t frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_lastFrameEnd).count();
+	Config::GBA.fps = 1000000000.0 / (double)(std::max)(frameTime, (int64_t)1);
+	m_lastFrameEnd = now;
+	measureSpeed(now);
+
+	if (!paced)
+	{
+		//keep the deadline close so turning pacing back on doesn't try to catch up
+		resync(now);
+		return;
+	}
+
+	advanceDeadline();
+	recordFrameTime(frameTime);
+}
+
+void FramePacer::resync(clock::time_point now)
+{
+	m_syncPoint = now;
+	m_framesSinceSync = 0;
+	advanceDeadline();
+}
+
+void FramePacer::advanceDeadline()
+{
+	m_framesSinceSync++;
+	m_deadline = m_syncPoint + std::chrono::nanoseconds((int64_t)((double)m_framesSinceSync * frameNanoseconds / m_speed));
+}
+
+void FramePacer::measureSpeed(clock::time_point now)
+{
+	m_speedMeasureFrames++;
+	if (m_speedMeasureFrames < speedMeasureFrames)
+		return;
+	int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_speedMeasureStart).count();
+	Config::GBA.achievedSpeed = ((double)m_speedMeasureFrames * frameNanoseconds) / (double)(std::max)(elapsed, (int64_t)1);
+	m_speedMeasureStart = now;
+	m_speedMeasureFrames = 0;
+}
+
+void FramePacer::waitUntil(clock::time_point deadline)
+{
+	while (true)
+	{
+		clock::time_point now = clock::now();
+		int64_t remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+		if (remaining <= 0)
+			return;
+
+		if (remaining <= m_sleepMargin)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		int64_t sleepTime = remaining - m_sleepMargin;
+		std::this_thread::sleep_for(std::chrono::nanoseconds(sleepTime));
+		int64_t overshoot = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - now).count() - sleepTime;
+		if (overshoot > m_sleepMargin)
+			m_sleepMargin = overshoot;
+		else
+			m_sleepMargin -= (m_sleepMargin - overshoot) / 16;
+		m_sleepMargin = std::clamp(m_sleepMargin, minSleepMargin, maxSleepMargin);
+	}
+}
+
+void FramePacer::recordFrameTime(int64_t frameTime)
+{
+	int64_t deviation = frameTime - (int64_t)(frameNanoseconds / m_speed);
+	int64_t offset = deviation + ((jitterBuckets / 2) * jitterBucketWidth) + (jitterBucketWidth / 2);	//shifted so the middle bucket is centred on zero
+	int bucket = (offset < 0) ? 0 : (int)(std::min)(offset / jitterBucketWidth, (int64_t)(jitterBuckets - 1));
+	m_jitterHistogram[bucket]++;
+	m_worstLateness = (std::max)(m_worstLateness, deviation);
+	m_jitterFrames++;
+	if (m_jitterFrames == jitterLogInterval)
+	{
+		if (Config::GBA.logFramePacing)
+			logJitter();
+		memset(m_jitterHistogram, 0, sizeof(m_jitterHistogram));
+		m_jitterFrames = 0;
+		m_worstLateness = 0;
+	}
+}
+
+void FramePacer::logJitter()
+{
+	std::string histogram;
+	for (int i = 0; i < jitterBuckets; i++)
+	{
+		if (!m_jitterHistogram[i])
+			continue;
+		double bucketMs = (double)((i - (jitterBuckets / 2)) * jitterBucketWidth) / 1000000.0;
+		histogram += std::format(" {:+.2f}ms:{}", bucketMs, m_jitterHistogram[i]);
+	}
+	Logger::getInstance()->msg(LoggerSeverity::Info, std::format("Frame pacing over {} frames - worst {:.2f}ms late, sleep margin {:.2f}ms. Frame time deviation:{}",
+		m_jitterFrames, (double)m_worstLateness / 1000000.0, (double)m_sleepMargin / 1000000.0, histogram));
+}
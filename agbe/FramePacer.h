@@ -0,0 +1,61 @@
+#pragma once
+
+#include"Logger.h"
+#include"Config.h"
+
+#include<chrono>
+#include<thread>
+#include<format>
+#include<algorithm>
+#include<cstring>
+
+//paces emulation to real time. deadlines are absolute (start + n frames), so error in one wait doesn't carry into the next and there's no drift.
+//waiting sleeps until it's close to the deadline and spins the rest - how close is learned from how late sleeps actually wake up, so a
+//paced instance only keeps a core busy for the last fraction of a millisecond each frame
+class FramePacer
+{
+public:
+	FramePacer();
+	~FramePacer();
+
+	void reset();						//start pacing from now, e.g. after loading or a pause
+	void endFrame(bool paced, double speed);	//called once per emulated frame. waits for the frame's deadline at 'speed'x if paced, otherwise just measures
+private:
+	using clock = std::chrono::steady_clock;
+
+	//one frame is 280896 cycles at 2^24 Hz = 16742706 + 153/512 ns, which a double holds exactly
+	static constexpr double frameNanoseconds = 16742706.298828125;
+	static constexpr int maxFramesBehind = 4;						//further behind than this, give up catching up and resync
+
+	//deadline n is m_syncPoint + n frames at m_speed, worked out from scratch each time so rounding doesn't pile up
+	clock::time_point m_syncPoint;
+	uint64_t m_framesSinceSync = 0;
+	double m_speed = 1.0;
+	clock::time_point m_deadline;
+	clock::time_point m_lastFrameEnd;
+	unsigned int m_timerPeriod = 1;		//ms the system timer's been asked to tick at while we're around, 0 if that failed
+	void resync(clock::time_point now);
+	void advanceDeadline();
+	void waitUntil(clock::time_point deadline);
+
+	//achieved speed, measured over a handful of frames so the title doesn't flicker
+	static constexpr int speedMeasureFrames = 30;
+	clock::time_point m_speedMeasureStart;
+	int m_speedMeasureFrames = 0;
+	void measureSpeed(clock::time_point now);
+
+	//sleeps end within this much of the deadline, then it's spun out. jumps up to any oversleep seen, decays slowly otherwise
+	static constexpr int64_t minSleepMargin = 200000;
+	static constexpr int64_t maxSleepMargin = 4000000;
+	int64_t m_sleepMargin = 1000000;
+
+	//frame time minus the ideal frame time, in 0.25ms buckets from -4ms to +4ms (ends catch everything past)
+	static constexpr int jitterBuckets = 33;
+	static constexpr int jitterBucketWidth = 250000;
+	static constexpr int jitterLogInterval = 600;
+	uint32_t m_jitterHistogram[jitterBuckets] = {};
+	uint32_t m_jitterFrames = 0;
+	int64_t m_worstLateness = 0;
+	void recordFrameTime(int64_t frameTime);
+	void logJitter();
+};
@@ -1,12 +1,14 @@
 #include"GBA.h"
 
-GBA::GBA()
+GBA::GBA() : m_mem(), m_interruptManager(m_scheduler), m_input(m_interruptManager), m_ppu(m_mem, m_interruptManager, m_scheduler),
+	m_bus(readFile((Config::GBA.exePath + (std::string)"\\rom\\gba_bios.bin").c_str()), readFile(Config::GBA.RomName.c_str()), m_mem, m_interruptManager, m_ppu, m_input, m_scheduler, m_debugger),
+	m_cpu(m_bus, m_interruptManager, m_scheduler)
 {
-	m_scheduler = std::make_shared<Scheduler>();
-	m_input = std::make_shared<Input>();
-	m_scheduler->addEvent(Event::Frame, &GBA::onEvent, (void*)this, 280896);
+	m_scheduler.addEvent(Event::Frame, &GBA::onEvent, (void*)this, 280896);
 	expectedNextFrame = 280896;
-	m_initialise();
+	Logger::getInstance()->msg(LoggerSeverity::Info, "ROM Path: " + Config::GBA.RomName);
+	Logger::getInstance()->msg(LoggerSeverity::Info, "Inited GBA instance!");
+	Config::GBA.shouldReset = false;
 }
 
 GBA::~GBA()
@@ -16,33 +18,43 @@ GBA::~GBA()
 
 void GBA::run()
 {
-	auto lastTime = std::chrono::high_resolution_clock::now();
-	m_lastTime = std::chrono::high_resolution_clock::now();
+	m_pacer.reset();
+	m_debugLoop = m_debugger.getEnabled();
 	while (!Config::GBA.shouldReset)
 	{
-		m_cpu->step();
+		//only drop into the debug loop when something's actually set - the normal loop doesn't check breakpoints at all
+		if (m_debugLoop)
+			runLoop<true>();
+		else
+			runLoop<false>();
 	}
 }
 
-void GBA::frameEventHandler()
+template<bool debug> void GBA::runLoop()
 {
-	auto curTime = std::chrono::high_resolution_clock::now();
-	double timeDiff = std::chrono::duration<double, std::milli>(curTime - m_lastTime).count();
-	Config::GBA.fps = 1.0 / (timeDiff / 1000);
-	if (!Config::GBA.disableVideoSync)
+	while (!Config::GBA.shouldReset && (m_debugLoop == debug))
 	{
-		static constexpr double target = ((280896.0) / (16777216.0)) * 1000;
-		while (timeDiff < target)
+		if constexpr (debug)
 		{
-			curTime = std::chrono::high_resolution_clock::now();
-			timeDiff = std::chrono::duration<double, std::milli>(curTime - m_lastTime).count();
+			if (m_debugger.shouldBreak(m_cpu.getExecutingPC()))
+			{
+				m_debugger.waitWhilePaused();
+				continue;
+			}
 		}
+		m_cpu.step<debug>();
 	}
-	m_lastTime = curTime;
-	m_ppu->updateDisplayOutput();	//maybe just move to vblank instead..
-	m_scheduler->addEvent(Event::Frame, &GBA::onEvent, (void*)this, m_scheduler->getEventTime() + 280896);
+}
 
-	m_input->tick();
+void GBA::frameEventHandler()
+{
+	//with audio sync, the apu waiting on the audio device does the pacing
+	m_pacer.endFrame(!Config::GBA.disableVideoSync && !m_bus.getAudioPacingEmulation(), std::clamp(Config::GBA.speedMultiplier, 0.25f, 16.0f));
+	m_bus.commitBackupMemory();	//hand any modified save pages to the flush thread
+	m_scheduler.addEvent(Event::Frame, &GBA::onEvent, (void*)this, m_scheduler.getEventTime() + 280896);
+
+	m_input.tick();
+	m_debugLoop = m_debugger.getEnabled();		//sampled once a frame, so the normal loop never touches the debugger's atomic
 
 }
 
@@ -57,51 +69,15 @@ void GBA::notifyDetach()
 	m_shouldStop = true;	//stops the instance (bc otherwise this thread will go on forever when main thread ends)
 }
 
-void* GBA::getPPUData()
+const void* GBA::getPPUData(uint64_t* frameSequence)
 {
-	return PPU::m_safeDisplayBuffer;
+	return m_ppu.acquireDisplayFrame(frameSequence);
 }
 
-void GBA::registerInput(std::shared_ptr<InputState> inp)
+void GBA::registerInput(std::shared_ptr<SharedInputState> inp)
 {
 	m_inp = inp;
-	m_input->registerInput(m_inp);
-}
-
-void GBA::m_destroy()
-{
-	if (!m_initialised)
-		return;
-
-	m_ppu.reset();
-	m_bus.reset();
-	m_cpu.reset();
-	m_scheduler->invalidateAll();
-	m_scheduler->addEvent(Event::Frame, &GBA::onEvent, (void*)this, 280896);
-	expectedNextFrame = 280896;
-}
-
-void GBA::m_initialise()
-{
-	Logger::getInstance()->msg(LoggerSeverity::Info, "Initializing new GBA instance");
-	std::string romName = Config::GBA.RomName;
-	if (romName == "")
-		return;
-	Logger::getInstance()->msg(LoggerSeverity::Info, "ROM Path: " + romName);
-
-	std::vector<uint8_t> romData = readFile(romName.c_str());
-	std::string biosPath = Config::GBA.exePath + (std::string)"\\rom\\gba_bios.bin";
-
-	std::vector<uint8_t> biosData = readFile(biosPath.c_str());
-
-	m_interruptManager = std::make_shared<InterruptManager>(m_scheduler);
-	m_ppu = std::make_shared<PPU>(m_interruptManager,m_scheduler);
-	m_bus = std::make_shared<Bus>(biosData, romData, m_interruptManager, m_ppu,m_input,m_scheduler);
-	m_cpu = std::make_shared<ARM7TDMI>(m_bus,m_interruptManager,m_scheduler);
-	m_input->registerInterrupts(m_interruptManager);
-	Logger::getInstance()->msg(LoggerSeverity::Info, "Inited GBA instance!");
-	m_initialised = true;
-	Config::GBA.shouldReset = false;
+	m_input.registerInput(m_inp);
 }
 
 std::vector<uint8_t> GBA::readFile(const char* name)
@@ -8,6 +8,8 @@
 #include"InterruptManager.h"
 #include"Config.h"
 #include"Scheduler.h"
+#include"Debugger.h"
+#include"FramePacer.h"
 
 #include<Windows.h>
 #include<mutex>
@@ -22,28 +24,33 @@ public:
 	void run();
 	void notifyDetach();
 
-	void* getPPUData();
-	void registerInput(std::shared_ptr<InputState> inp);
+	const void* getPPUData(uint64_t* frameSequence = nullptr);		//latest finished frame, plus its frame number if wanted
+	void setOutputFormat(OutputFormat format) { m_ppu.setOutputFormat(format); }		//call before run()
+	void registerInput(std::shared_ptr<SharedInputState> inp);
 	static void onEvent(void* context);
+
+	Debugger& getDebugger() { return m_debugger; }
 private:
-	std::shared_ptr<Bus> m_bus;
-	std::shared_ptr<InterruptManager> m_interruptManager;
-	std::shared_ptr<ARM7TDMI> m_cpu;
-	std::shared_ptr<PPU> m_ppu;
-	std::shared_ptr<Input> m_input;
-	std::shared_ptr<Scheduler> m_scheduler;
-	std::shared_ptr<InputState> m_inp;
+	template<bool debug> void runLoop();
+
+	//every component lives in here by value, so an instance is one allocation and components just hold references to each other.
+	//declaration order matters - each component is constructed after everything it references
+	Scheduler m_scheduler;
+	Debugger m_debugger;
+	GBAMem m_mem;
+	InterruptManager m_interruptManager;
+	Input m_input;
+	PPU m_ppu;
+	Bus m_bus;
+	ARM7TDMI m_cpu;
+	std::shared_ptr<SharedInputState> m_inp;
 
 	bool m_shouldStop = false;
-	std::chrono::steady_clock::time_point m_lastTime;
+	bool m_debugLoop = false;		//debugger state as of the last frame boundary - which run loop should be running
+	FramePacer m_pacer;
 	uint64_t expectedNextFrame = 0;
 	void frameEventHandler();
 
-	void m_destroy();
-	void m_initialise();
-
-	bool m_initialised = false;
-
-	std::vector<uint8_t> readFile(const char* name);
+	static std::vector<uint8_t> readFile(const char* name);
 	uint32_t safe_dispBuffer[240 * 160] = {};
 };
\ No newline at end of file
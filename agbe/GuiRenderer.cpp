@@ -35,6 +35,20 @@ void GuiRenderer::render()
 			{
 				m_menuItemSelected = true;
 				ImGui::MenuItem("Disable vid sync", nullptr, &Config::GBA.disableVideoSync);
+				ImGui::SliderFloat("Speed", &Config::GBA.speedMultiplier, 0.25f, 16.0f, "%.2fx", ImGuiSliderFlags_Logarithmic);
+				ImGui::Combo("Audio off 1x", (int*)&Config::GBA.fastForwardAudio, "Mute\0Drop\0Resample\0");
+				ImGui::MenuItem("Sync to audio", nullptr, &Config::GBA.audioSync);
+				ImGui::Combo("Audio output (on reset)", (int*)&Config::GBA.audioSink, "Device\0None\0WAV file\0Raw PCM file\0Pipe\0");
+				if (Config::GBA.audioSink != AudioSinkType::Device && Config::GBA.audioSink != AudioSinkType::Null)
+				{
+					if (ImGui::InputText("Output path", m_audioPathBuffer, sizeof(m_audioPathBuffer)))
+						Config::GBA.audioOutputPath = m_audioPathBuffer;
+				}
+				if (ImGui::InputInt("Sample rate (on reset)", &Config::GBA.audioSampleRate, 0))
+					Config::GBA.audioSampleRate = std::clamp(Config::GBA.audioSampleRate, 8000, 192000);
+				ImGui::MenuItem("Threaded renderer (on reset)", nullptr, &Config::GBA.threadedRenderer);
+				ImGui::MenuItem("Disable video", nullptr, &Config::GBA.noVideo);
+				ImGui::SliderInt("Frame skip", &Config::GBA.frameSkip, 0, 9);
 				ImGui::EndMenu();
 			}
 		}
@@ -75,4 +89,5 @@ void GuiRenderer::render()
 
 bool GuiRenderer::m_openFileDialog = false;
 bool GuiRenderer::m_autoHideMenu = true;
-bool GuiRenderer::m_menuItemSelected = false;
\ No newline at end of file
+bool GuiRenderer::m_menuItemSelected = false;
+char GuiRenderer::m_audioPathBuffer[260] = {};
\ No newline at end of file
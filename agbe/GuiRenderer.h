@@ -3,6 +3,7 @@
 #include<iostream>
 #include<Windows.h>
 #include<format>
+#include<algorithm>
 #include<imgui.h>
 #include<imgui_impl_glfw.h>
 #include<imgui_impl_opengl3.h>
@@ -20,4 +21,5 @@ private:
 	static bool m_openFileDialog;
 	static bool m_autoHideMenu;
 	static bool m_menuItemSelected;
+	static char m_audioPathBuffer[260];		//imgui edits this, it's copied into the config on change
 };
\ No newline at end of file
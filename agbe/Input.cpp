@@ -1,6 +1,6 @@
 #include"Input.h"
 
-Input::Input()
+Input::Input(InterruptManager& interruptManager) : m_interruptManager(interruptManager)
 {
 	keyInput = 0xFFFF;
 }
@@ -10,32 +10,64 @@ Input::~Input()
 
 }
 
-void Input::registerInput(std::shared_ptr<InputState> inputState)
+void SharedInputState::update(InputState state)
 {
-	m_inputState = inputState;
-	keyInput = 0xFFFF;
-	KEYCNT = 0;
+	if (m_keys.load(std::memory_order_relaxed) == state.reg)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);		//store under the lock so a waiter can't check then miss the notify
+		m_keys.store(state.reg, std::memory_order_release);
+	}
+	m_changed.notify_all();
+}
+
+void SharedInputState::waitForChange(uint16_t lastSeen)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_changed.wait(lock, [&] { return m_keys.load(std::memory_order_acquire) != lastSeen || Config::GBA.shouldReset; });
+}
+
+void SharedInputState::wakeWaiters()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+	}
+	m_changed.notify_all();
 }
 
-void Input::registerInterrupts(std::shared_ptr<InterruptManager> interruptManager)
+void Input::registerInput(std::shared_ptr<SharedInputState> inputState)
 {
-	m_interruptManager = interruptManager;
+	m_inputState = inputState;
+	keyInput = 0xFFFF;
+	KEYCNT = 0;
 }
 
 void Input::tick()
 {
-	uint16_t newInputState = (~(m_inputState->reg)) & 0x3FF;
+	uint16_t newInputState = (~(m_inputState->get())) & 0x3FF;
 	bool shouldCheckIRQ = (newInputState != keyInput);
 	keyInput = newInputState;
 	if (shouldCheckIRQ)					//i'm confused.. if the irq was already asserted when KEYCNT written, then we can just trigger the irq on key input change
 	{									//....otherwise, recheck if the irq can happen?? wtf is my code doing??
 		if (irqActive)
-			m_interruptManager->requestInterrupt(InterruptType::Keypad);
+			m_interruptManager.requestInterrupt(InterruptType::Keypad);
 		else
 			checkIRQ();
 	}
 }
 
+void Input::waitForWakeup()
+{
+	while (true)
+	{
+		uint16_t keys = m_inputState->get();
+		tick();
+		if (getIRQConditionsMet() || Config::GBA.shouldReset)		//<-- potentially game pak or SIO irq could exit stop
+			return;													//but fwiw games only really use stop for 'sleep mode', exited thru the joypad
+		m_inputState->waitForChange(keys);
+	}
+}
+
 bool Input::getIRQConditionsMet()
 {
 	bool irqMode = ((KEYCNT >> 15) & 0b1);
@@ -85,6 +117,6 @@ void Input::checkIRQ()
 	bool shouldDoIRQ = getIRQConditionsMet();
 
 	if (shouldDoIRQ)
-		m_interruptManager->requestInterrupt(InterruptType::Keypad);
+		m_interruptManager.requestInterrupt(InterruptType::Keypad);
 	irqActive = shouldDoIRQ;
 }
@@ -1,7 +1,11 @@
 #pragma once
 
 #include<iostream>
+#include<atomic>
+#include<mutex>
+#include<condition_variable>
 #include"Logger.h"
+#include"Config.h"
 #include"Scheduler.h"
 #include"InterruptManager.h"
 
@@ -29,24 +33,39 @@ union InputState
 	};
 };
 
+//keypad state handed from the ui thread to the emu thread. the ui publishes all keys in one store, and anything blocked waiting on
+//input (STOP) gets woken up by it rather than spinning
+class SharedInputState
+{
+public:
+	void update(InputState state);				//ui thread
+	uint16_t get() { return m_keys.load(std::memory_order_acquire); }
+	void waitForChange(uint16_t lastSeen);		//emu thread. returns once keys differ from lastSeen, or a reset's been requested
+	void wakeWaiters();							//call after setting shouldReset, so a stopped instance notices
+private:
+	std::atomic<uint16_t> m_keys = 0;
+	std::mutex m_lock;
+	std::condition_variable m_changed;
+};
+
 class Input
 {
 public:
-	Input();
+	Input(InterruptManager& interruptManager);
 	~Input();
 
-	void registerInput(std::shared_ptr<InputState> inputState);
-	void registerInterrupts(std::shared_ptr<InterruptManager> interruptManager);
+	void registerInput(std::shared_ptr<SharedInputState> inputState);
 
 	uint8_t readIORegister(uint32_t address);
 	void writeIORegister(uint32_t address, uint8_t value);
 	void tick();
 	bool getIRQConditionsMet();
+	void waitForWakeup();		//STOP - blocks until the keypad meets KEYCNT's condition
 private:
 	void checkIRQ();
 
-	std::shared_ptr<InputState> m_inputState;
-	std::shared_ptr<InterruptManager> m_interruptManager;
+	std::shared_ptr<SharedInputState> m_inputState;
+	InterruptManager& m_interruptManager;
 	uint64_t lastEventTime = 0;
 	uint16_t keyInput = 0;
 	uint16_t KEYCNT = 0;
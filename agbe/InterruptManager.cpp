@@ -1,8 +1,7 @@
 #include"InterruptManager.h"
 
-InterruptManager::InterruptManager(std::shared_ptr<Scheduler> scheduler)
+InterruptManager::InterruptManager(Scheduler& scheduler) : m_scheduler(scheduler)
 {
-	m_scheduler = scheduler;
 	IE = 0; IF = 0;
 }
 
@@ -81,12 +80,12 @@ void InterruptManager::checkIRQs()
 	pendingIrq = ((IF & IE & 0b0011111111111111));
 	if (pendingIrq)																													//new irq? schedule irq signal change
 	{
-		m_scheduler->addEvent(Event::IRQ, &InterruptManager::eventHandler, (void*)this, m_scheduler->getCurrentTimestamp() + 4);
-		m_scheduler->forceSync(4);
+		m_scheduler.addEvent(Event::IRQ, &InterruptManager::eventHandler, (void*)this, m_scheduler.getCurrentTimestamp() + 4);
+		m_scheduler.forceSync(4);
 	}
 	else																															//not completely sure. maybe IF&IE going 0 while in the synchronizer could cancel the irq?
 	{
-		m_scheduler->removeEvent(Event::IRQ);
+		m_scheduler.removeEvent(Event::IRQ);
 		irqAvailable = false;
 	}																									
 }
\ No newline at end of file
@@ -23,7 +23,7 @@ enum class InterruptType	//todo: more interrupt sources!
 class InterruptManager
 {
 public:
-	InterruptManager(std::shared_ptr<Scheduler> scheduler);
+	InterruptManager(Scheduler& scheduler);
 	~InterruptManager();
 
 	void requestInterrupt(InterruptType intType);
@@ -38,7 +38,7 @@ private:
 	void checkIRQs();
 	bool irqAvailable = false;
 	bool pendingIrq = false;
-	std::shared_ptr<Scheduler> m_scheduler;
+	Scheduler& m_scheduler;
 	uint16_t IE = {};
 	uint16_t IF = {};
 	uint16_t IME = {};
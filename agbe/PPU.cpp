@@ -1,71 +1,226 @@
 #include"PPU.h"
 
-PPU::PPU(std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler)
+PPU::PPU(GBAMem& mem, InterruptManager& interruptManager, Scheduler& scheduler) : m_interruptManager(interruptManager), m_scheduler(scheduler),
+	m_paletteRAM(mem.paletteRAM), m_VRAM(mem.VRAM), m_OAM(mem.OAM), m_displayBuffers(std::make_unique<DisplayBuffers>()), m_display(m_displayBuffers.get())
 {
-	m_scheduler = scheduler;
-	m_interruptManager = interruptManager;
+	m_blendLine = selectBlendLine();
+	memset(m_tileDirty, 1, sizeof(m_tileDirty));
+	setOutputFormat(OutputFormat::RGBA8888);
 	reset();
 
 	for (int i = 0; i < 4; i++)			//initially clear all fields in bg layer structs
-	{
-		m_windows[i] = {};
 		m_backgroundLayers[i] = {};
-	}
+	m_windows[0] = {};
+	m_windows[1] = {};
 
+	if (Config::GBA.threadedRenderer)
+		startRenderThread();
 }
 
 PPU::~PPU()
 {
-
+	stopRenderThread();
 }
 
 void PPU::reset()
 {
 	//reset ppu state, reschedule hdraw vcount=0
-	m_scheduler->removeEvent(Event::PPU);
-	m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, m_scheduler->getCurrentTimestamp() + 1006);
+	m_scheduler.removeEvent(Event::PPU);
+	m_lineStartTimestamp = m_scheduler.getCurrentTimestamp() - 1;		//first hblank is 1006 cycles in
+	scheduleLinePhase(LinePhase::HBlankStart);
+	if (m_renderWorker)
+		pushLineCommand(RenderCommandType::Reset);
+	resetRenderState();
+}
+
+void PPU::resetRenderState()
+{
 	VCOUNT = 0;
 	inVBlank = false;
-	m_state = PPUState::HDraw;
-	memset(m_renderBuffer, 0, 240 * 160 * 8);
-	updateDisplayOutput();
+	memset(m_display->buffers[pageIdx], 0, sizeof(DisplayBuffers::buffers[0]));
+	invalidateScanlineRecords();
 }
 
-void PPU::updateDisplayOutput()
+void PPU::publishFrame()
 {
-	memcpy(m_safeDisplayBuffer, m_renderBuffer[!pageIdx], 240 * 160 * sizeof(uint32_t));
+	m_display->sequence[pageIdx] = ++m_display->framesPublished;
+	pageIdx = m_display->ready.exchange(pageIdx | DisplayBuffers::freshFrame, std::memory_order_acq_rel) & 0b11;
 }
 
-void PPU::registerMemory(std::shared_ptr<GBAMem> mem)
+const void* PPU::acquireDisplayFrame(uint64_t* sequence)
 {
-	registered = true;
-	m_mem = mem;
+	if (m_display->ready.load(std::memory_order_relaxed) & DisplayBuffers::freshFrame)
+		m_display->front = m_display->ready.exchange(m_display->front, std::memory_order_acq_rel) & 0b11;
+	if (sequence)
+		*sequence = m_display->sequence[m_display->front];
+	return m_display->buffers[m_display->front];
 }
 
 void PPU::eventHandler()
 {
-	uint64_t schedTimestamp = m_scheduler->getEventTime();
-
-	switch (m_state)
+	switch (m_linePhase)
 	{
-	case PPUState::HDraw:
-		HDraw();
+	case LinePhase::HBlankStart:
+		onHBlankStart();
 		break;
-	case PPUState::HBlank:
-		HBlank();
+	case LinePhase::HBlankIRQ:
+		m_interruptManager.requestInterrupt(InterruptType::HBlank);
+		scheduleLinePhase(LinePhase::LineEnd);
 		break;
-	case PPUState::VBlank:
-		VBlank();
+	case LinePhase::LineEnd:
+		onLineEnd();
 		break;
 	}
 }
 
-void PPU::triggerHBlankIRQ()
+void PPU::scheduleLinePhase(LinePhase phase)
+{
+	m_linePhase = phase;
+	m_scheduler.addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, m_lineStartTimestamp + linePhaseOffsets[(int)phase]);
+}
+
+void PPU::scheduleLine()
+{
+	//drawing lines render and trigger hblank dma at hblank, and video capture runs up to line 161. past that, hblank only matters for the irq
+	//(the hblank flag is worked out from the timestamp when dispstat is read)
+	if (VCOUNT < 162)
+		scheduleLinePhase(LinePhase::HBlankStart);
+	else if ((DISPSTAT >> 4) & 0b1)
+		scheduleLinePhase(LinePhase::HBlankIRQ);
+	else
+		scheduleLinePhase(LinePhase::LineEnd);
+}
+
+void PPU::onHBlankStart()
+{
+	bool drawing = (VCOUNT < 160);
+	if (drawing)
+	{
+		if (VCOUNT == 0)
+			m_skipFrame = shouldSkipFrame();
+
+		if (!m_skipFrame)
+		{
+			if (m_renderWorker)
+				pushLineCommand(RenderCommandType::DrawLine);
+			else
+				renderLine();
+		}
+		DMAHBlankCallback(callbackContext);
+	}
+
+	//timing for video capture is wrong! should fix!
+	if (VCOUNT >= 2 && VCOUNT < 162)
+		DMAVideoCaptureCallback(callbackContext);
+
+	if (((DISPSTAT >> 4) & 0b1))
+		scheduleLinePhase(LinePhase::HBlankIRQ);
+	else
+		scheduleLinePhase(LinePhase::LineEnd);
+}
+
+bool PPU::shouldSkipFrame()
+{
+	if (Config::GBA.noVideo)
+		return true;
+	if (Config::GBA.frameSkip <= 0)
+		return false;
+	m_frameCounter++;
+	return (m_frameCounter % (Config::GBA.frameSkip + 1)) != 0;
+}
+
+void PPU::renderLine()
+{
+	ScanlineRecord& record = m_scanlineRecords[VCOUNT];
+	ScanlineInputs inputs;
+	captureScanlineInputs(inputs);
+	if (record.valid && !memcmp(&inputs, &record.inputs, sizeof(ScanlineInputs)))
+	{
+		//nothing this line depends on has changed since it was last drawn, so reuse that output
+		if (record.page != pageIdx)
+		{
+			uint32_t lineOffset = 240 * VCOUNT * m_bytesPerPixel;
+			memcpy((uint8_t*)m_display->buffers[pageIdx] + lineOffset, (uint8_t*)m_display->buffers[record.page] + lineOffset, 240 * m_bytesPerPixel);
+			record.page = pageIdx;
+		}
+		BG2X_latch = record.BGAffineLatchesAfter[0]; BG2Y_latch = record.BGAffineLatchesAfter[1];
+		BG3X_latch = record.BGAffineLatchesAfter[2]; BG3Y_latch = record.BGAffineLatchesAfter[3];
+		affineVerticalMosaicCounter = record.verticalMosaicCounterAfter;
+		m_linesReused++;
+		return;
+	}
+
+	drawScanline();
+	memcpy(&record.inputs, &inputs, sizeof(ScanlineInputs));
+	record.BGAffineLatchesAfter[0] = BG2X_latch; record.BGAffineLatchesAfter[1] = BG2Y_latch;
+	record.BGAffineLatchesAfter[2] = BG3X_latch; record.BGAffineLatchesAfter[3] = BG3Y_latch;
+	record.verticalMosaicCounterAfter = affineVerticalMosaicCounter;
+	record.page = pageIdx;
+	record.valid = true;
+	m_linesRendered++;
+}
+
+void PPU::captureScanlineInputs(ScanlineInputs& inputs)
+{
+	memset(&inputs, 0, sizeof(ScanlineInputs));		//padding too, since these get memcmp'd
+	inputs.DISPCNT = DISPCNT;
+	inputs.BGCNT[0] = BG0CNT; inputs.BGCNT[1] = BG1CNT; inputs.BGCNT[2] = BG2CNT; inputs.BGCNT[3] = BG3CNT;
+	inputs.BGHOFS[0] = BG0HOFS; inputs.BGHOFS[1] = BG1HOFS; inputs.BGHOFS[2] = BG2HOFS; inputs.BGHOFS[3] = BG3HOFS;
+	inputs.BGVOFS[0] = BG0VOFS; inputs.BGVOFS[1] = BG1VOFS; inputs.BGVOFS[2] = BG2VOFS; inputs.BGVOFS[3] = BG3VOFS;
+	inputs.BGAffineParams[0] = BG2PA; inputs.BGAffineParams[1] = BG2PB; inputs.BGAffineParams[2] = BG2PC; inputs.BGAffineParams[3] = BG2PD;
+	inputs.BGAffineParams[4] = BG3PA; inputs.BGAffineParams[5] = BG3PB; inputs.BGAffineParams[6] = BG3PC; inputs.BGAffineParams[7] = BG3PD;
+	inputs.BGAffineLatches[0] = BG2X_latch; inputs.BGAffineLatches[1] = BG2Y_latch;
+	inputs.BGAffineLatches[2] = BG3X_latch; inputs.BGAffineLatches[3] = BG3Y_latch;
+	inputs.windows[0] = m_windows[0];
+	inputs.windows[1] = m_windows[1];
+	inputs.WININ = WININ;
+	inputs.WINOUT = WINOUT;
+	inputs.BLDCNT = BLDCNT;
+	inputs.BLDALPHA = BLDALPHA;
+	inputs.BLDY = BLDY;
+	inputs.MOSAIC = MOSAIC;
+	inputs.verticalMosaicCounter = affineVerticalMosaicCounter;
+	inputs.paletteGeneration = m_paletteGeneration;
+
+	//bitmap modes move the bg/obj split in vram up by one 16KB block
+	bool bitmapMode = getBitmapMode();
+	uint8_t vramBlocks = 0;
+	bool anyBackground = false;
+	for (int i = 0; i < 4; i++)
+	{
+		inputs.bgEnabled[i] = m_backgroundLayers[i].enabled;
+		anyBackground |= m_backgroundLayers[i].enabled;
+	}
+	if (anyBackground)
+		vramBlocks |= (bitmapMode) ? 0b011111 : 0b001111;
+	if ((DISPCNT >> 12) & 0b1)
+	{
+		vramBlocks |= (bitmapMode) ? 0b100000 : 0b110000;
+		inputs.oamGeneration = m_oamGeneration;
+	}
+	for (int i = 0; i < 6; i++)
+	{
+		if ((vramBlocks >> i) & 0b1)
+			inputs.vramGeneration[i] = m_vramGeneration[i];
+	}
+}
+
+void PPU::invalidateScanlineRecords()
 {
-	m_interruptManager->requestInterrupt(InterruptType::HBlank);
+	for (int i = 0; i < 160; i++)
+		m_scanlineRecords[i].valid = false;
 }
 
-void PPU::HDraw()
+void PPU::updateLineReuseStats()
+{
+	uint32_t totalLines = m_linesRendered + m_linesReused;
+	if (totalLines)
+		Config::GBA.lineReusePercent = ((double)m_linesReused / (double)totalLines) * 100.0;
+	m_linesRendered = 0;
+	m_linesReused = 0;
+}
+
+void PPU::drawScanline()
 {
 	uint8_t mode = DISPCNT & 0b111;
 	switch (mode)
@@ -94,49 +249,55 @@ void PPU::HDraw()
 	for (int i = 0; i < 4; i++)
 		m_backgroundLayers[i].masterEnable = false;
 	affineHorizontalMosaicCounter = 0;
+}
 
-	if (((DISPSTAT >> 4) & 0b1))
-		m_scheduler->addEvent(Event::HBlankIRQ, &PPU::onHBlankIRQEvent, (void*)this, m_scheduler->getEventTime() + 4);
-	DMAHBlankCallback(callbackContext);
-
-	//timing for video capture is wrong! should fix!
-	if (VCOUNT >= 2)
-		DMAVideoCaptureCallback(callbackContext);
+void PPU::onLineEnd()
+{
+	m_lineStartTimestamp += linePhaseOffsets[(int)LinePhase::LineEnd];
+	if (VCOUNT < 160)
+	{
+		advanceDrawLine();
+		checkVCOUNTInterrupt();
+		if (VCOUNT == 160)
+		{
+			setVBlankFlag(true);
+			if (((DISPSTAT >> 3) & 0b1))
+				m_interruptManager.requestInterrupt(InterruptType::VBlank);
+			DMAVBlankCallback(callbackContext);
+		}
+	}
+	else
+	{
+		advanceVBlankLine();
+		if (VCOUNT == 0 || VCOUNT == 227)		//back to drawing, or last line of vblank - where the flag goes low
+			setVBlankFlag(false);
+		checkVCOUNTInterrupt();
+	}
+	scheduleLine();
+}
 
-	setHBlankFlag(true);
-	m_state = PPUState::HBlank;
-	m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, m_scheduler->getEventTime() + 225);
+bool PPU::getHBlankFlag()
+{
+	return m_scheduler.getCurrentTimestamp() >= (m_lineStartTimestamp + linePhaseOffsets[(int)LinePhase::HBlankStart]);
 }
 
-void PPU::HBlank()
+//the parts of each line transition that rendering depends on. split out so the render thread can replay them in the same order as io/memory writes
+void PPU::advanceDrawLine()
 {
-	uint64_t schedTimestamp = m_scheduler->getEventTime();
-	setHBlankFlag(false);
-	m_lineCycles = 0;
+	if (m_renderWorker)
+		pushLineCommand(RenderCommandType::EndDrawLine, m_skipFrame);
 
 	VCOUNT++;
-
-	checkVCOUNTInterrupt();
-
 	if (VCOUNT == 160)
 	{
-		setVBlankFlag(true);
 		inVBlank = true;
-
-		if (((DISPSTAT >> 3) & 0b1))
-			m_interruptManager->requestInterrupt(InterruptType::VBlank);
-
-		pageIdx = !pageIdx;
-
-		m_state = PPUState::VBlank;
-		m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, schedTimestamp+1007);
-
-		DMAVBlankCallback(callbackContext);
-
+		if (!m_skipFrame && !m_renderWorker)		//skipped frames leave the last rendered one up. in threaded mode the render thread publishes instead
+		{
+			publishFrame();
+			updateLineReuseStats();
+		}
 		return;
 	}
-	else
-		m_state = PPUState::HDraw;
 
 	//see if we need to latch new vals into affine regs (e.g. if they were modified outside of vblank)
 	if (BG2X_dirty)
@@ -151,34 +312,15 @@ void PPU::HBlank()
 
 	//attempt to latch in new enable bits for bg
 	latchBackgroundEnableBits();
-
-	m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, schedTimestamp+1007);
 }
 
-void PPU::VBlank()
+void PPU::advanceVBlankLine()
 {
-	uint64_t schedTimestamp = m_scheduler->getEventTime();
-	m_lineCycles = 0;
-	m_state=PPUState::VBlank;
+	if (m_renderWorker)
+		pushLineCommand(RenderCommandType::EndVBlankLine);
 
-	if (!vblank_setHblankBit)	//handle first part of line, up until hblank
-	{
-		setHBlankFlag(true);
-
-		if (((DISPSTAT >> 4) & 0b1))
-			m_scheduler->addEvent(Event::HBlankIRQ, &PPU::onHBlankIRQEvent, (void*)this, schedTimestamp + 4);
-
-		vblank_setHblankBit = true;
-		m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, schedTimestamp+225);
-		if (VCOUNT < 162)
-			DMAVideoCaptureCallback(callbackContext);
-		return;
-	}
-
-	vblank_setHblankBit = false;	//end of vblank for current line
-	setHBlankFlag(false);
 	VCOUNT++;
-	if (VCOUNT == 228)		//go back to drawing
+	if (VCOUNT == 228)
 	{
 		//copy over new values to affine regs
 		BG2X_latch = BG2X;
@@ -189,17 +331,8 @@ void PPU::VBlank()
 
 		affineVerticalMosaicCounter = 0;
 
-		setVBlankFlag(false);
 		inVBlank = false;
 		VCOUNT = 0;
-		checkVCOUNTInterrupt();
-		m_state = PPUState::HDraw;
-	}
-	else
-	{
-		if (VCOUNT == 227)			//set vblank flag false on last line of vblank (if applicable)
-			setVBlankFlag(false);
-		checkVCOUNTInterrupt();
 	}
 
 	//attempt to latch in new enable bits for bg. i think this is instant in vblank as there being a 3 scanline delay would make no sense..
@@ -212,7 +345,6 @@ void PPU::VBlank()
 			m_backgroundLayers[i].enabled = true;
 		}
 	}
-	m_scheduler->addEvent(Event::PPU, &PPU::onSchedulerEvent, (void*)this, schedTimestamp + 1007);
 }
 
 void PPU::checkVCOUNTInterrupt()
@@ -221,7 +353,7 @@ void PPU::checkVCOUNTInterrupt()
 	bool vcountMatches = (vcountCompare == VCOUNT);
 	setVCounterFlag(vcountMatches);
 	if (vcountMatches && ((DISPSTAT >> 5) & 0b1) && !vcountIRQLine)
-		m_interruptManager->requestInterrupt(InterruptType::VCount);
+		m_interruptManager.requestInterrupt(InterruptType::VCount);
 	vcountIRQLine = vcountMatches;
 }
 
@@ -283,6 +415,12 @@ void PPU::renderMode3()
 		int16_t pC = (int16_t)BG2PC;
 
 		m_backgroundLayers[2].priorityBits = BG2CNT & 0b11;
+		if (!mosaic)
+		{
+			drawBitmapLine<240, 160, 2>(0, xRef, yRef, pA, pC);
+			m_updateAffineRegisters(mosaic,2);
+			return;
+		}
 		for (int i = 0; i < 240; i++, m_calcAffineCoords(mosaic,xRef,yRef,pA,pC))
 		{
 			uint32_t xCoord = (xRef >> 8) & 0xFFFFF;
@@ -293,8 +431,8 @@ void PPU::renderMode3()
 				continue;
 			}
 			uint32_t address = (yCoord * 480) + (xCoord * 2);
-			uint8_t colLow = m_mem->VRAM[address];
-			uint8_t colHigh = m_mem->VRAM[address + 1];
+			uint8_t colLow = m_VRAM[address];
+			uint8_t colHigh = m_VRAM[address + 1];
 			uint16_t col = ((colHigh << 8) | colLow);
 			m_backgroundLayers[2].lineBuffer[i] = col & 0x7FFF;
 		}
@@ -324,6 +462,12 @@ void PPU::renderMode4()
 		int16_t pA = (int16_t)BG2PA;
 		int16_t pC = (int16_t)BG2PC;
 		m_backgroundLayers[2].priorityBits = BG2CNT & 0b11;
+		if (!mosaic)
+		{
+			drawBitmapLine<240, 160, 1>(base, xRef, yRef, pA, pC);
+			m_updateAffineRegisters(mosaic,2);
+			return;
+		}
 		for (int i = 0; i < 240; i++, m_calcAffineCoords(mosaic,xRef,yRef,pA,pC))
 		{
 			uint32_t xCoord = (xRef >> 8) & 0xFFFFF;
@@ -334,13 +478,8 @@ void PPU::renderMode4()
 				continue;
 			}
 			uint32_t address = base + (yCoord * 240) + xCoord;
-			uint8_t curPaletteIdx = m_mem->VRAM[address];
-			uint16_t paletteAddress = (uint16_t)curPaletteIdx * 2;
-			uint8_t paletteLow = m_mem->paletteRAM[paletteAddress];
-			uint8_t paletteHigh = m_mem->paletteRAM[paletteAddress + 1];
-
-			uint16_t paletteData = ((paletteHigh << 8) | paletteLow);
-			m_backgroundLayers[2].lineBuffer[i] = paletteData & 0x7FFF;
+			uint8_t curPaletteIdx = m_VRAM[address];
+			m_backgroundLayers[2].lineBuffer[i] = m_paletteCache[curPaletteIdx];
 		}
 	}
 	m_updateAffineRegisters(mosaic,2);
@@ -369,6 +508,12 @@ void PPU::renderMode5()
 		int16_t pC = (int16_t)BG2PC;
 
 		m_backgroundLayers[2].priorityBits = BG2CNT & 0b11;
+		if (!mosaic)
+		{
+			drawBitmapLine<160, 128, 2>(baseAddr, xRef, yRef, pA, pC);
+			m_updateAffineRegisters(mosaic,2);
+			return;
+		}
 		for (int i = 0; i < 240; i++, m_calcAffineCoords(mosaic,xRef,yRef,pA,pC))
 		{
 			uint32_t xCoord = (xRef >> 8) & 0xFFFFF;
@@ -380,8 +525,8 @@ void PPU::renderMode5()
 			}
 
 			uint32_t address = baseAddr + (yCoord * 320) + (xCoord * 2);
-			uint8_t colLow = m_mem->VRAM[address];
-			uint8_t colHigh = m_mem->VRAM[address + 1];
+			uint8_t colLow = m_VRAM[address];
+			uint8_t colHigh = m_VRAM[address + 1];
 			uint16_t col = (colHigh << 8) | colLow;
 			m_backgroundLayers[2].lineBuffer[i] = col & 0x7FFF;
 		}
@@ -391,20 +536,21 @@ void PPU::renderMode5()
 
 void PPU::composeLayers()
 {
-	uint16_t backDrop = *(uint16_t*)m_mem->paletteRAM & 0x7FFF;
+	uint16_t backDrop = m_paletteCache[0];
 	int spriteMosaicHorizontal = ((MOSAIC >> 8) & 0xF) + 1;
 	int spriteHorizontalMosaicCounter = 0;
 	int spriteMosaicX = 0;
 	bool mosaicInProcess = false;
+	if (((DISPCNT >> 7) & 0b1))				//forced blank -> white screen (all 1s is white in every output format)
+	{
+		memset((uint8_t*)m_display->buffers[pageIdx] + (240 * VCOUNT * m_bytesPerPixel), 0xFF, 240 * m_bytesPerPixel);
+		return;
+	}
+
+	buildWindowMask();
 	for (int x = 0; x < 240; x++)
 	{	
-		if (((DISPCNT >> 7) & 0b1))				//forced blank -> white screen
-		{
-			m_renderBuffer[pageIdx][(240 * VCOUNT) + x] = 0xFFFFFFFF;
-			continue;
-		}
-
-		Window pointInfo = getWindowAttributes(x, VCOUNT);
+		uint8_t windowMask = m_windowMask[x];
 
 		uint16_t finalCol = backDrop;
 		bool transparentSpriteTop = false;
@@ -420,7 +566,7 @@ void PPU::composeLayers()
 		int highestPriority = 255;
 		for (int layer = 3; layer >= 0; layer--)
 		{
-			if (m_backgroundLayers[layer].enabled && m_backgroundLayers[layer].masterEnable && pointInfo.layerDrawable[layer])	//layer activated
+			if (m_backgroundLayers[layer].enabled && m_backgroundLayers[layer].masterEnable && ((windowMask >> layer) & 0b1))	//layer activated
 			{
 				uint16_t colAtLayer = m_backgroundLayers[layer].lineBuffer[x];
 				if (!((colAtLayer >> 15) & 0b1))
@@ -455,7 +601,7 @@ void PPU::composeLayers()
 			}
 		}
 		
-		if (((DISPCNT >> 12) & 0b1) && pointInfo.objDrawable)
+		if (((DISPCNT >> 12) & 0b1) && ((windowMask >> 4) & 0b1))
 		{
 			//sprite mosaic seems to be a post process thing? idk
 			int spriteX = x;
@@ -495,9 +641,10 @@ void PPU::composeLayers()
 		}
 
 		//not sure about this. pokemon ruby depends on semi-transparent sprites bypassing the blend enable check. todo: confirm on hardware!
-		if (pointInfo.blendable || transparentSpriteTop)
+		uint8_t blendMode = 0;
+		if (((windowMask >> 5) & 0b1) || transparentSpriteTop)
 		{
-			uint8_t blendMode = ((BLDCNT >> 6) & 0b11);
+			blendMode = ((BLDCNT >> 6) & 0b11);
 			if (transparentSpriteTop)	
 			{
 				if (!(blendPixelB >> 15))									//i think blend mode only gets overridden if there's a second target pixel?
@@ -505,24 +652,14 @@ void PPU::composeLayers()
 				else if (!((BLDCNT >> 4) & 0b1) && (blendPixelB >> 15))		//hmm, if it's only 'semi-transparent' but there's no target B (and sprite not target A), then don't blend??
 					blendMode = 0;
 			}
-			switch (blendMode)
-			{
-			case 1:
-				if(!(blendPixelA >> 15) && !(blendPixelB >> 15))
-					finalCol = blendAlpha(blendPixelA, blendPixelB);
-				break;
-			case 2:
-				if (!(blendPixelA>>15))
-					finalCol = blendBrightness(blendPixelA, true);
-				break;
-			case 3:
-				if (!(blendPixelA>>15))
-					finalCol = blendBrightness(blendPixelA, false);
-				break;
-			}
+			if ((blendPixelA >> 15) || (blendMode == 1 && (blendPixelB >> 15)))	//missing a target, so nothing to blend
+				blendMode = 0;
 		}
 
-		m_renderBuffer[pageIdx][(240 * VCOUNT) + x] = col16to32(finalCol);
+		m_composeTop[x] = finalCol;
+		m_composeTargetA[x] = blendPixelA;
+		m_composeTargetB[x] = blendPixelB;
+		m_composeBlendMode[x] = blendMode;
 
 		spriteHorizontalMosaicCounter++;
 		if (spriteHorizontalMosaicCounter == spriteMosaicHorizontal)
@@ -533,6 +670,9 @@ void PPU::composeLayers()
 			mosaicInProcess = false;
 		}
 	}
+
+	(this->*m_blendLine)();
+	writeOutputLine();
 }
 
 void PPU::drawBackground(int bg)
@@ -608,8 +748,8 @@ void PPU::drawBackground(int bg)
 		uint32_t bgMapBaseAddress = ((bgMapBaseBlock + baseBlockOffset) * 2048) + bgMapYIdx;
 		bgMapBaseAddress += ((normalizedTileFetchIdx>>3) * 2);
 
-		uint8_t tileLower = m_mem->VRAM[bgMapBaseAddress];
-		uint8_t tileHigher = m_mem->VRAM[bgMapBaseAddress + 1];
+		uint8_t tileLower = m_VRAM[bgMapBaseAddress];
+		uint8_t tileHigher = m_VRAM[bgMapBaseAddress + 1];
 		uint16_t tile = ((uint16_t)tileHigher << 8) | tileLower;
 
 		uint32_t tileNumber = tile & 0x3FF;
@@ -626,6 +766,7 @@ void PPU::drawBackground(int bg)
 
 		uint32_t tileMapBaseAddress = (tileDataBaseBlock * 16384) + (tileNumber * tileByteSizeLUT[hiColor]); //find correct tile based on just the tile number
 		tileMapBaseAddress += (yMod8 * tileRowPitchLUT[hiColor]);									//then extract correct row of tile info, row pitch says how large each row is in bytes
+		const uint8_t* tileRow = (hiColor) ? &m_VRAM[tileMapBaseAddress] : getTileRow4bpp(tileMapBaseAddress);	//one palette index per pixel
 
 		//todo: clean this bit up
 		int initialTileIdx = ((tileFetchIdx >> 3) & 0xFF);
@@ -636,31 +777,12 @@ void PPU::drawBackground(int bg)
 			if (horizontalFlip)
 				pixelOffset = 7 - pixelOffset;
 			uint16_t col = 0x8000;
-			if (hiColor)
+			int colorId = tileRow[pixelOffset];
+			if (colorId)
 			{
-				int paletteEntry = m_mem->VRAM[tileMapBaseAddress + pixelOffset];
-				uint32_t paletteMemoryAddr = paletteEntry << 1;
-
-				if (paletteEntry)
-				{
-					uint8_t colLow = m_mem->paletteRAM[paletteMemoryAddr];
-					uint8_t colHigh = m_mem->paletteRAM[paletteMemoryAddr + 1];
-					col = ((colHigh << 8) | colLow) & 0x7FFF;
-				}
-			}
-			else
-			{
-				uint8_t tileData = m_mem->VRAM[tileMapBaseAddress + (pixelOffset >> 1)];
-				int stepTile = ((pixelOffset & 0b1)) << 2;
-				int colorId = ((tileData >> stepTile) & 0xf);
-				if (colorId)
-				{
-					uint32_t paletteMemoryAddr = paletteNumber * 32;
-					paletteMemoryAddr += (colorId * 2);
-					uint8_t colLow = m_mem->paletteRAM[paletteMemoryAddr];
-					uint8_t colHigh = m_mem->paletteRAM[paletteMemoryAddr + 1];
-					col = ((colHigh << 8) | colLow) & 0x7FFF;
-				}
+				if (!hiColor)
+					colorId += paletteNumber * 16;
+				col = m_paletteCache[colorId];
 			}
 
 			if (screenX < 240)
@@ -724,6 +846,15 @@ void PPU::drawRotationScalingBackground(int bg)
 	m_backgroundLayers[bg].priorityBits = bgPriority;
 
 	bool mosaicEnabled = (ctrlReg >> 6) & 0b1;
+	if (!mosaicEnabled)
+	{
+		if (overflowWrap)
+			drawAffineTileLine<true>(bg, screenSize, bgMapBaseBlock * 2048, tileDataBaseBlock * 16384, xRef, yRef, pA, pC);
+		else
+			drawAffineTileLine<false>(bg, screenSize, bgMapBaseBlock * 2048, tileDataBaseBlock * 16384, xRef, yRef, pA, pC);
+		m_updateAffineRegisters(mosaicEnabled,bg);
+		return;
+	}
 
 	for (int x = 0; x < 240; x++, m_calcAffineCoords(mosaicEnabled,xRef,yRef,pA,pC))
 	{
@@ -750,7 +881,7 @@ void PPU::drawRotationScalingBackground(int bg)
 		{
 			uint32_t bgMapAddr = (bgMapBaseBlock * 2048) + bgMapYIdx;
 			bgMapAddr += (xCoord>>3);
-			tileIdx = m_mem->VRAM[bgMapAddr];
+			tileIdx = m_VRAM[bgMapAddr];
 			cachedTileIdx = tileIdx;
 		}
 		cachedXCoord = (xCoord>>3);
@@ -766,6 +897,59 @@ void PPU::drawRotationScalingBackground(int bg)
 	m_updateAffineRegisters(mosaicEnabled,bg);
 }
 
+void PPU::buildSpriteLists()
+{
+	static constexpr int spriteXBoundsLUT[12] = { 8,16,32,64,16,32,32,64,8,8,16,32 };
+	static constexpr int spriteYBoundsLUT[12] = { 8,16,32,64,8,8,16,32,16,32,32,64 };
+	static constexpr int xPitchLUT[12] = { 1,2,4,8,2,4,4,8,1,1,2,4 };
+
+	memset(m_spriteLineCount, 0, sizeof(m_spriteLineCount));
+	for (int i = 0; i < 128; i++)
+	{
+		OAMEntry* curSpriteEntry = (OAMEntry*)(m_OAM + (i * 8));	//each OAM entry is 8 bytes
+		if (!curSpriteEntry->rotateScale && curSpriteEntry->disableObj)
+			continue;
+
+		SpriteInfo& sprite = m_spriteInfo[i];
+		sprite.affine = curSpriteEntry->rotateScale;
+		sprite.doubleSize = sprite.affine && curSpriteEntry->disableObj;	//odd: bit 9 is 'double-size' flag with affine sprites
+		sprite.top = curSpriteEntry->yCoord;
+		if (sprite.top >= 160)							//bit of a dumb hack to accommodate for when sprites are offscreen
+			sprite.top -= 256;
+		sprite.left = curSpriteEntry->xCoord;
+		if (sprite.left >= 240)
+			sprite.left -= 512;
+
+		int spriteBoundsLookupId = (curSpriteEntry->shape << 2) | curSpriteEntry->size;
+		sprite.width = spriteXBoundsLUT[spriteBoundsLookupId];
+		sprite.height = spriteYBoundsLUT[spriteBoundsLookupId];
+		sprite.hiColor = curSpriteEntry->bitDepth;
+		sprite.rowPitch = xPitchLUT[spriteBoundsLookupId] * ((sprite.hiColor) ? 2 : 1);	//how many tiles we have to 'cross' to get to next row (in 1d mapping)
+		sprite.charName = curSpriteEntry->charName;
+		sprite.priority = curSpriteEntry->priority;
+		sprite.paletteNumber = curSpriteEntry->paletteNumber;
+		sprite.flipHorizontal = curSpriteEntry->xFlip;
+		sprite.flipVertical = curSpriteEntry->yFlip;
+		sprite.mosaic = curSpriteEntry->mosaic;
+		sprite.semiTransparent = (curSpriteEntry->objMode == 1);
+		sprite.objWindow = (curSpriteEntry->objMode == 2);
+		sprite.affineParams = (curSpriteEntry->data >> 25) & 0x1F;
+
+		int spriteBottom = sprite.top + ((sprite.doubleSize) ? sprite.height * 2 : sprite.height);
+		for (int line = max(sprite.top, 0); line < min(spriteBottom, 160); line++)
+			m_spriteLines[line][m_spriteLineCount[line]++] = i;
+	}
+
+	for (int i = 0; i < 32; i++)
+	{
+		uint32_t parameterBase = (i * 0x20) + 6;
+		for (int j = 0; j < 4; j++)
+			m_spriteAffineParams[i][j] = m_OAM[parameterBase + (j * 8)] | (m_OAM[parameterBase + (j * 8) + 1] << 8);
+	}
+
+	m_spriteListGeneration = m_oamGeneration;
+}
+
 void PPU::drawSprites(bool bitmapMode)
 {
 	memset(m_spriteAttrBuffer, 0b00011111, 240);
@@ -773,217 +957,102 @@ void PPU::drawSprites(bool bitmapMode)
 	m_spriteCyclesElapsed = 0;
 	if (!((DISPCNT >> 12) & 0b1))
 		return;
-	bool oneDimensionalMapping = ((DISPCNT >> 6) & 0b1);
-	bool isBlendTarget1 = ((BLDCNT >> 4) & 0b1);
-	bool isBlendTarget2 = ((BLDCNT >> 12) & 0b1);
-	uint8_t blendMode = ((BLDCNT >> 6) & 0b11);
+	if (m_spriteListGeneration != m_oamGeneration)		//oam's changed since the lists were built
+		buildSpriteLists();
 
-	int mosaicHorizontal = ((MOSAIC >> 8) & 0xF) + 1;
+	bool oneDimensionalMapping = ((DISPCNT >> 6) & 0b1);
 	int mosaicVertical = ((MOSAIC >> 12) & 0xF) + 1;
 
 	bool limitSpriteCycles = ((DISPCNT >> 5) & 0b1);
 	int maxAllowedSpriteCycles = (limitSpriteCycles) ? 954 : 1210;	//with h-blank interval free set, then less cycles can be spent rendering sprites
 
-	for (int i = 0; i < 128; i++)
+	//only sprites overlapping this line are in the list (still in oam order). the rest never added any cycles, so the budget works out the same
+	for (int spriteIdx = 0; spriteIdx < m_spriteLineCount[VCOUNT]; spriteIdx++)
 	{
 		if (m_spriteCyclesElapsed > maxAllowedSpriteCycles)	//quit sprite rendering if we've spent too much time evaluating sprites
 			return;
-		uint32_t spriteBase = i * 8;	//each OAM entry is 8 bytes
-
-		OAMEntry* curSpriteEntry = (OAMEntry*)(m_mem->OAM+spriteBase);
 
-		if(curSpriteEntry->rotateScale)
+		const SpriteInfo& sprite = m_spriteInfo[m_spriteLines[VCOUNT][spriteIdx]];
+		if (sprite.affine)
 		{
-			drawAffineSprite(curSpriteEntry);
+			drawAffineSprite(sprite);
 			continue;
 		}
 
-		if (curSpriteEntry->disableObj)
-			continue;
-
-		//uint8_t objMode = (curSpriteEntry->attr0 >> 10) & 0b11;	
-		bool isObjWindow = curSpriteEntry->objMode == 2;
-		//bool mosaic = (curSpriteEntry->attr0 >> 12) & 0b1;
-
 		int renderY = VCOUNT;
-		if (curSpriteEntry->mosaic)
+		if (sprite.mosaic)
 			renderY = (renderY / mosaicVertical) * mosaicVertical;
-
-		int spriteTop = curSpriteEntry->yCoord;
-		if (spriteTop >= 160)							//bit of a dumb hack to accommodate for when sprites are offscreen
-			spriteTop -= 256;
-		int spriteLeft = curSpriteEntry->xCoord;
-		if (spriteLeft >= 240)
-			spriteLeft -= 512;
-		if (spriteTop > renderY)	//nope. sprite is offscreen or too low
+		if (sprite.top > renderY)	//mosaic can pull us back above the sprite
 			continue;
-		int spriteBottom = 0, spriteRight = 0;
-		int rowPitch = 1;	//find out how many lines we have to 'cross' to get to next row (in 1d mapping)
-		//need to find out dimensions first to figure out whether to ignore this object
-		int spritePriority = curSpriteEntry->priority;
-
-		int spriteBoundsLookupId = (curSpriteEntry->shape << 2) | curSpriteEntry->size;
-		static constexpr int spriteXBoundsLUT[12] ={8,16,32,64,16,32,32,64,8,8,16,32};
-		static constexpr int spriteYBoundsLUT[12] ={8,16,32,64,8,8,16,32,16,32,32,64};
-		static constexpr int xPitchLUT[12] ={1,2,4,8,2,4,4,8,1,1,2,4};
-
-		spriteRight = spriteLeft + spriteXBoundsLUT[spriteBoundsLookupId];
-		spriteBottom = spriteTop + spriteYBoundsLUT[spriteBoundsLookupId];
-		rowPitch = xPitchLUT[spriteBoundsLookupId];	
-		if (VCOUNT >= spriteBottom)	//nope, we're past it.
-			continue;
-
-		bool flipHorizontal = curSpriteEntry->xFlip;
-		bool flipVertical = curSpriteEntry->yFlip;
 
-		int spriteYSize = (spriteBottom - spriteTop);	//find out how big sprite is
-		int yOffsetIntoSprite = renderY - spriteTop;
-		if (flipVertical)
-			yOffsetIntoSprite = (spriteYSize-1) - yOffsetIntoSprite;//flip y coord we're considering
-
-		uint32_t tileId = curSpriteEntry->charName;
-		bool hiColor = curSpriteEntry->bitDepth;
-		if (hiColor)
-			rowPitch *= 2;
+		int yOffsetIntoSprite = renderY - sprite.top;
+		if (sprite.flipVertical)
+			yOffsetIntoSprite = (sprite.height - 1) - yOffsetIntoSprite;//flip y coord we're considering
 
 		//check y coord, then adjust tile id as necessary
-		while (yOffsetIntoSprite >= 8)
-		{
-			yOffsetIntoSprite -= 8;
-			if (!oneDimensionalMapping)
-				tileId += 32;	//add 32 to get to next tile row with 2d mapping
-			else
-				tileId += rowPitch; //otherwise, add the row pitch (which says how many tiles exist per row)
-		}
+		uint32_t tileId = sprite.charName;
+		if (!oneDimensionalMapping)
+			tileId += (yOffsetIntoSprite >> 3) * 32;	//add 32 to get to next tile row with 2d mapping
+		else
+			tileId += (yOffsetIntoSprite >> 3) * sprite.rowPitch; //otherwise, add the row pitch (which says how many tiles exist per row)
+		yOffsetIntoSprite &= 7;
 
 		if (bitmapMode && tileId < 512)		//bitmap mode: only tiles 512-1023 are displayable. ignore all others
 			continue;
 
-		uint32_t objBase = 0x10000;
-		if (!hiColor)
-		{
-			objBase += (tileId * 32);
-			objBase += (yOffsetIntoSprite * 4);	//finally add corrected y offset
-		}
-		else
-		{
-			objBase += ((tileId) * 32);
-			objBase += (yOffsetIntoSprite * 8);
-		}
+		uint32_t objBase = 0x10000 + (tileId * 32) + (yOffsetIntoSprite * ((sprite.hiColor) ? 8 : 4));
 
 		//add cycles taken to evaluate sprite
-		m_spriteCyclesElapsed += (spriteRight - spriteLeft);
+		m_spriteCyclesElapsed += sprite.width;
 
-		int numXTilesToRender = (spriteRight - spriteLeft) / 8;
+		int numXTilesToRender = sprite.width / 8;
 		for (int xSpanTile = 0; xSpanTile < numXTilesToRender; xSpanTile++)
 		{
 			int curXSpanTile = xSpanTile;
-			if (flipHorizontal)
+			if (sprite.flipHorizontal)
 				curXSpanTile = ((numXTilesToRender - 1) - curXSpanTile);	//flip render order if horizontal flip !!
-			uint32_t tileMapLookupAddr = objBase + (curXSpanTile * ((hiColor) ? 64 : 32));
+			uint32_t tileMapLookupAddr = objBase + (curXSpanTile * ((sprite.hiColor) ? 64 : 32));
 
 			for (int x = 0; x < 8; x++)
 			{
 				int baseX = x;
-				if (flipHorizontal)
+				if (sprite.flipHorizontal)
 					baseX = 7 - baseX;
 
-				int plotCoord = (xSpanTile * 8) + x + spriteLeft;
+				int plotCoord = (xSpanTile * 8) + x + sprite.left;
 				if (plotCoord > 239 || plotCoord < 0)
 					continue;
 
-				uint16_t col = extractColorFromTile(tileMapLookupAddr, baseX, hiColor, true, curSpriteEntry->paletteNumber);
-
-				if (isObjWindow)
-				{
-					if(!(col>>15))
-						m_spriteAttrBuffer[plotCoord].objWindow = 1;
-					continue;
-				}
-
-				uint8_t priorityAtPixel = m_spriteAttrBuffer[plotCoord].priority;
-				bool renderedPixelTransparent = m_spriteLineBuffer[plotCoord] >> 15;
-				bool currentPixelTransparent = col >> 15;
-				if ((spritePriority >= priorityAtPixel) && (!renderedPixelTransparent || currentPixelTransparent))	//keep rendering if lower priority, BUT last pixel transparent
-					continue;
-
-				m_spriteAttrBuffer[plotCoord].priority = spritePriority & 0b11111;
-				m_spriteAttrBuffer[plotCoord].transparent = (curSpriteEntry->objMode == 1);
-				m_spriteAttrBuffer[plotCoord].mosaic = curSpriteEntry->mosaic;
-				if(!currentPixelTransparent)
-					m_spriteLineBuffer[plotCoord] = col;
+				uint16_t col = extractColorFromTile(tileMapLookupAddr, baseX, sprite.hiColor, true, sprite.paletteNumber);
+				plotSpritePixel(sprite, plotCoord, col);
 			}
 		}
-
 	}
 }
 
-void PPU::drawAffineSprite(OAMEntry* curSpriteEntry)
+void PPU::drawAffineSprite(const SpriteInfo& sprite)
 {
 	bool oneDimensionalMapping = ((DISPCNT >> 6) & 0b1);
-	bool isBlendTarget1 = ((BLDCNT >> 4) & 0b1);
-	bool isBlendTarget2 = ((BLDCNT >> 12) & 0b1);
-	uint8_t blendMode = ((BLDCNT >> 6) & 0b11);
-
-	bool isObjWindow = (curSpriteEntry->objMode == 2);
-	bool doubleSize = curSpriteEntry->disableObj;	//odd: bit 9 is 'double-size' flag with affine sprites
-
-	int spriteTop = curSpriteEntry->yCoord;
-	if (spriteTop >= 160)
-		spriteTop -= 256;
-	int spriteLeft = curSpriteEntry->xCoord;
-	if (spriteLeft >= 240)
-		spriteLeft -= 512;
-
-	if (spriteTop > VCOUNT)
-		return;
 
-	int spriteBottom = 0, spriteRight = 0;
-	int rowPitch = 1;	//find out how many lines we have to 'cross' to get to next row (in 1d mapping)
-
-	//need to find out dimensions first to figure out whether to ignore this object
-	int spriteBoundsLookupId = (curSpriteEntry->shape << 2) | curSpriteEntry->size;
-	static constexpr int spriteXBoundsLUT[12] = { 8,16,32,64,16,32,32,64,8,8,16,32 };
-	static constexpr int spriteYBoundsLUT[12] = { 8,16,32,64,8,8,16,32,16,32,32,64 };
-	static constexpr int xPitchLUT[12] = { 1,2,4,8,2,4,4,8,1,1,2,4 };
-
-
-	spriteRight = spriteLeft + spriteXBoundsLUT[spriteBoundsLookupId];
-	spriteBottom = spriteTop + spriteYBoundsLUT[spriteBoundsLookupId];
-	rowPitch = xPitchLUT[spriteBoundsLookupId];
-	int doubleSizeOffset = ((spriteBottom - spriteTop)) * doubleSize;
-	if (VCOUNT >= (spriteBottom+doubleSizeOffset))	//nope, we're past it.
-		return;
-
-	uint32_t tileId = curSpriteEntry->charName;
-	bool hiColor = curSpriteEntry->bitDepth;
-	if (hiColor)
-		rowPitch *= 2;
-	int yOffsetIntoSprite = VCOUNT - spriteTop;
-	int xBase = 0;
-
-	int halfWidth = (spriteRight - spriteLeft) / 2;
-	int halfHeight = (spriteBottom - spriteTop) / 2;
-	int spriteWidth = halfWidth * 2;
-	int spriteHeight = halfHeight * 2;	//find out how big sprite is
+	int yOffsetIntoSprite = VCOUNT - sprite.top;
+	int halfWidth = sprite.width / 2;
+	int halfHeight = sprite.height / 2;
+	int spriteWidth = sprite.width;
+	int spriteHeight = sprite.height;
 
 	//add evaluation cycles. doublesize sprites take up more because twice the amount of pixels are rendered.
 	m_spriteCyclesElapsed += 10;
-	m_spriteCyclesElapsed += (spriteWidth * 2) * (doubleSize ? 2 : 1);
-
-	//get affine parameters
-	uint32_t parameterSelection = (curSpriteEntry->data >> 25) & 0x1F;
-	parameterSelection *= 0x20;
-	parameterSelection += 6;
-	int16_t PA = m_mem->OAM[parameterSelection] | ((m_mem->OAM[parameterSelection + 1]) << 8);
-	int16_t PB = m_mem->OAM[parameterSelection + 8] | ((m_mem->OAM[parameterSelection + 9]) << 8);
-	int16_t PC = m_mem->OAM[parameterSelection + 16] | ((m_mem->OAM[parameterSelection + 17]) << 8);
-	int16_t PD = m_mem->OAM[parameterSelection + 24] | ((m_mem->OAM[parameterSelection + 25]) << 8);
-	for (int x = 0; x < spriteWidth * ((doubleSize)?2:1); x++)
+	m_spriteCyclesElapsed += (spriteWidth * 2) * (sprite.doubleSize ? 2 : 1);
+
+	int16_t PA = m_spriteAffineParams[sprite.affineParams][0];
+	int16_t PB = m_spriteAffineParams[sprite.affineParams][1];
+	int16_t PC = m_spriteAffineParams[sprite.affineParams][2];
+	int16_t PD = m_spriteAffineParams[sprite.affineParams][3];
+	for (int x = 0; x < spriteWidth * ((sprite.doubleSize)?2:1); x++)
 	{
 		int ix = (x - halfWidth);
 		int iy = (yOffsetIntoSprite - halfHeight);
-		if (doubleSize)
+		if (sprite.doubleSize)
 		{
 			ix = (x - spriteWidth);
 			iy = (yOffsetIntoSprite - spriteHeight);
@@ -995,87 +1064,59 @@ void PPU::drawAffineSprite(OAMEntry* curSpriteEntry)
 		if (py >= spriteHeight || px >= spriteWidth)
 			continue;
 
-		uint32_t baseTileId = tileId;
-		uint32_t yCorrection = 0;
-		uint32_t yOffs = py;
-		while (yOffs >= 8)
-		{
-			yOffs -= 8;
-			if (!oneDimensionalMapping)
-				baseTileId += 32;	//add 32 to get to next tile row with 2d mapping
-			else
-				baseTileId += rowPitch; //otherwise, add the row pitch (which says how many tiles exist per row)
-		}
+		uint32_t baseTileId = sprite.charName;
+		if (!oneDimensionalMapping)
+			baseTileId += (py >> 3) * 32;	//add 32 to get to next tile row with 2d mapping
+		else
+			baseTileId += (py >> 3) * sprite.rowPitch; //otherwise, add the row pitch (which says how many tiles exist per row)
 		uint32_t objBaseAddress = 0x10000 + (baseTileId * 32);
-		yCorrection = (yOffs * ((hiColor) ? 8 : 4));
-
+		uint32_t yCorrection = ((py & 7) * ((sprite.hiColor) ? 8 : 4));
 
 		int curXSpanTile = px /8;
 		int xOffsIntoTile = px & 7;
-		uint32_t tileMapLookupAddr = objBaseAddress + yCorrection + (curXSpanTile * ((hiColor) ? 64 : 32));
+		uint32_t tileMapLookupAddr = objBaseAddress + yCorrection + (curXSpanTile * ((sprite.hiColor) ? 64 : 32));
 
-		int plotCoord = x + spriteLeft;
+		int plotCoord = x + sprite.left;
 		if (plotCoord > 239 || plotCoord < 0)
 			continue;
 
-		uint16_t col = extractColorFromTile(tileMapLookupAddr, xOffsIntoTile, hiColor, true, curSpriteEntry->paletteNumber);
-
-		if (isObjWindow)
-		{
-			if (!(col >> 15))
-				m_spriteAttrBuffer[plotCoord].objWindow = 1;
-			continue;
-		}
-
-		uint8_t priorityAtPixel = m_spriteAttrBuffer[plotCoord].priority;
-		bool renderedPixelTransparent = m_spriteLineBuffer[plotCoord] >> 15;
-		bool currentPixelTransparent = col >> 15;
-		if ((curSpriteEntry->priority >= priorityAtPixel) && (!renderedPixelTransparent || currentPixelTransparent))	//same as for normal, only stop if we're transparent (and lower priority)
-			continue;																						//...or last pixel isn't transparent
-		m_spriteAttrBuffer[plotCoord].priority = curSpriteEntry->priority&0b11111;
-		m_spriteAttrBuffer[plotCoord].transparent = (curSpriteEntry->objMode == 1);
-		m_spriteAttrBuffer[plotCoord].mosaic = curSpriteEntry->mosaic;	
-		if (!currentPixelTransparent)
-			m_spriteLineBuffer[plotCoord] = col;
+		uint16_t col = extractColorFromTile(tileMapLookupAddr, xOffsIntoTile, sprite.hiColor, true, sprite.paletteNumber);
+		plotSpritePixel(sprite, plotCoord, col);
 	}
-
 }
 
 uint16_t PPU::extractColorFromTile(uint32_t tileBase, uint32_t xOffset, bool hiColor, bool sprite, uint32_t palette)
 {
-	uint16_t col = 0;
-	uint32_t paletteMemoryAddr = 0;
+	uint32_t paletteIdx = 0;
 	if (sprite)
-		paletteMemoryAddr = 0x200;
+		paletteIdx = 256;
 	if (!hiColor)
 	{
-		tileBase += (xOffset/2);
-
-		uint8_t tileData = m_mem->VRAM[tileBase];
-		int colorId = 0;
-		int stepTile = ((xOffset & 0b1)) << 2;
-		colorId = ((tileData >> stepTile) & 0xf);	//first (even) pixel - low nibble. second (odd) pixel - high nibble
+		int colorId = getTileRow4bpp(tileBase)[xOffset];
 		if (!colorId)
 			return 0x8000;
 
-		paletteMemoryAddr += palette * 32;
-		paletteMemoryAddr += (colorId * 2);
+		paletteIdx += (palette * 16) + colorId;
 	}
 	else
 	{
 		tileBase += xOffset;
-		uint8_t tileData = m_mem->VRAM[tileBase];
+		uint8_t tileData = m_VRAM[tileBase];
 		if (!tileData)
 			return 0x8000;
-		paletteMemoryAddr += (tileData * 2);
+		paletteIdx += tileData;
 	}
 
-	uint8_t colLow = m_mem->paletteRAM[paletteMemoryAddr];
-	uint8_t colHigh = m_mem->paletteRAM[paletteMemoryAddr + 1];
-
-	col = (colHigh << 8) | colLow;
+	return m_paletteCache[paletteIdx];
+}
 
-	return col & 0x7fff;
+void PPU::decodeTileRow(const uint8_t* src, uint8_t* dst)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		dst[i * 2] = src[i] & 0xF;			//first (even) pixel - low nibble. second (odd) pixel - high nibble
+		dst[(i * 2) + 1] = (src[i] >> 4) & 0xF;
+	}
 }
 
 uint16_t PPU::blendBrightness(uint16_t col, bool increase)
@@ -1128,45 +1169,72 @@ uint16_t PPU::blendAlpha(uint16_t colA, uint16_t colB)
 	return (redA & 0x1F) | ((greenA & 0x1F) << 5) | ((blueA & 0x1F) << 10);
 }
 
-uint32_t PPU::col16to32(uint16_t col)
+void PPU::setOutputFormat(OutputFormat format)
 {
-	int red = (col & 0b0000000000011111);
-	red = (red << 3) | (red >> 2);
-	int green = (col & 0b0000001111100000) >> 5;
-	green = (green << 3) | (green >> 2);
-	int blue = (col & 0b0111110000000000) >> 10;
-	blue = (blue << 3) | (blue >> 2);
-
-	return (red << 24) | (green << 16) | (blue << 8) | 0x000000FF;
-
+	if (m_renderWorker)
+		pushLineCommand(RenderCommandType::SetOutputFormat, (uint32_t)format);
+	m_outputFormat = format;
+	invalidateScanlineRecords();
+	m_bytesPerPixel = (format == OutputFormat::RGB565) ? 2 : 4;
+	for (uint32_t col = 0; col < 32768; col++)
+	{
+		uint32_t red = (col & 0x1F);
+		uint32_t green = (col >> 5) & 0x1F;
+		uint32_t blue = (col >> 10) & 0x1F;
+		if (format == OutputFormat::RGB565)
+			green = (green << 1) | (green >> 4);	//565 keeps 5 bit red/blue, green widens to 6
+		else
+		{
+			red = (red << 3) | (red >> 2);
+			green = (green << 3) | (green >> 2);
+			blue = (blue << 3) | (blue >> 2);
+		}
+		switch (format)
+		{
+		case OutputFormat::RGB565:
+			m_outputLUT[col] = (red << 11) | (green << 5) | blue; break;
+		case OutputFormat::RGBA8888:
+			m_outputLUT[col] = (red << 24) | (green << 16) | (blue << 8) | 0x000000FF; break;
+		case OutputFormat::BGRA8888:
+			m_outputLUT[col] = (blue << 24) | (green << 16) | (red << 8) | 0x000000FF; break;
+		case OutputFormat::XRGB8888:
+			m_outputLUT[col] = 0xFF000000 | (red << 16) | (green << 8) | blue; break;
+		}
+	}
 }
 
-Window PPU::getWindowAttributes(int x, int y)
+void PPU::buildWindowMask()
 {
-	Window activeWindow = {};
+	//window boundaries can only change between lines, so work out which window each pixel is in once per line
 	bool window0Enabled = ((DISPCNT >> 13) & 0b1);
 	bool window1Enabled = ((DISPCNT >> 14) & 0b1);
 	bool objWindowEnabled = ((DISPCNT >> 15) & 0b1) && ((DISPCNT >> 12) & 0b1);
 	if (!(window0Enabled || window1Enabled || objWindowEnabled))		//drawable if neither window enabled
 	{
-		activeWindow.blendable = true;
-		activeWindow.objDrawable = true;
-		activeWindow.layerDrawable[0] = true; activeWindow.layerDrawable[1] = true;
-		activeWindow.layerDrawable[2] = true; activeWindow.layerDrawable[3] = true;
-		return activeWindow;
+		memset(m_windowMask, 0x3F, 240);
+		return;
 	}
-	
+
+	uint8_t outsideMask = WINOUT & 0x3F;
+	uint8_t objWindowMask = (WINOUT >> 8) & 0x3F;
+	for (int x = 0; x < 240; x++)
+		m_windowMask[x] = (objWindowEnabled && m_spriteAttrBuffer[x].objWindow) ? objWindowMask : outsideMask;
+
+	//win0 has priority over win1, so draw its span last
 	//todo: handling garbage window y coords isn't completely correct. should fix !!
-	for (int i = 0; i < 2; i++)
+	int y = VCOUNT;
+	for (int i = 1; i >= 0; i--)
 	{
-		if (((DISPCNT >> (13 + i)) & 0b1) && (x >= m_windows[i].x1 && (x < m_windows[i].x2 || m_windows[i].x1 > m_windows[i].x2)) && (y >= m_windows[i].y1 && (y < m_windows[i].y2 || m_windows[i].y1 > m_windows[i].y2)))
-			return m_windows[i];
+		if (!((DISPCNT >> (13 + i)) & 0b1))
+			continue;
+		if (!(y >= m_windows[i].y1 && (y < m_windows[i].y2 || m_windows[i].y1 > m_windows[i].y2)))
+			continue;
+		int start = m_windows[i].x1;
+		int end = (m_windows[i].x1 > m_windows[i].x2) ? 240 : m_windows[i].x2;
+		if (start >= end)
+			continue;
+		memset(m_windowMask + start, (WININ >> (i * 8)) & 0x3F, min(end, 240) - start);
 	}
-	if (objWindowEnabled && m_spriteAttrBuffer[x].objWindow)
-		return m_windows[2];
-
-	//if point not in any window 
-	return m_windows[3];
 }
 
 void PPU::latchBackgroundEnableBits()
@@ -1194,12 +1262,6 @@ void PPU::setVBlankFlag(bool value)
 	DISPSTAT |= value;
 }
 
-void PPU::setHBlankFlag(bool value)
-{
-	DISPSTAT &= ~0b10;
-	DISPSTAT |= (value << 1);
-}
-
 void PPU::setVCounterFlag(bool value)
 {
 	DISPSTAT &= ~0b100;
@@ -1215,7 +1277,7 @@ uint8_t PPU::readIO(uint32_t address)
 	case 0x04000001:
 		return ((DISPCNT >> 8) & 0xFF);
 	case 0x04000004:
-		return DISPSTAT & 0xFF;
+		return (DISPSTAT & 0xFD) | (getHBlankFlag() << 1);
 	case 0x04000005:
 		return ((DISPSTAT >> 8) & 0xFF);
 	case 0x04000006:
@@ -1262,6 +1324,9 @@ uint8_t PPU::readIO(uint32_t address)
 
 void PPU::writeIO(uint32_t address, uint8_t value)
 {
+	if (m_renderWorker && (address < 0x04000004 || address > 0x04000007))	//dispstat/vcount don't affect rendering
+		pushRenderCommand(RenderCommandType::IOWrite, address, value);
+
 	switch (address)
 	{
 	case 0x04000000:
@@ -1291,6 +1356,11 @@ void PPU::writeIO(uint32_t address, uint8_t value)
 	case 0x04000004:
 		DISPSTAT &= 0b1111111100000111; value &= 0b11111000;
 		DISPSTAT |= value;
+		if (VCOUNT >= 162 && !getHBlankFlag())	//hblank irq enable decides whether these lines stop at hblank, and we haven't got there yet
+		{
+			m_scheduler.removeEvent(Event::PPU);
+			scheduleLine();
+		}
 		break;
 	case 0x04000005:
 		DISPSTAT &= 0x00FF; DISPSTAT |= (value << 8);
@@ -1392,33 +1462,17 @@ void PPU::writeIO(uint32_t address, uint8_t value)
 	case 0x04000047:
 		m_windows[1].y1 = value;
 		break;
-	case 0x04000048:												//WININ/WINOUT code could be rewritten to avoid this duplication stuff..
+	case 0x04000048:
 		WININ &= 0xFF00; WININ |= value;
-		for (int i = 0; i < 4; i++)
-			m_windows[0].layerDrawable[i] = (WININ >> i) & 0b1;
-		m_windows[0].objDrawable = (WININ >> 4) & 0b1;
-		m_windows[0].blendable = (WININ >> 5) & 0b1;
 		break;
 	case 0x04000049:
 		WININ &= 0xFF; WININ |= (value << 8);
-		for (int i = 0; i < 4; i++)
-			m_windows[1].layerDrawable[i] = (WININ >> (8 + i)) & 0b1;
-		m_windows[1].objDrawable = (WININ >> 12) & 0b1;
-		m_windows[1].blendable = (WININ >> 13) & 0b1;
 		break;
 	case 0x0400004A:
 		WINOUT &= 0xFF00; WINOUT |= value;
-		for (int i = 0; i < 4; i++)
-			m_windows[3].layerDrawable[i] = (WINOUT >> i) & 0b1;
-		m_windows[3].objDrawable = (WINOUT >> 4) & 0b1;
-		m_windows[3].blendable = (WINOUT >> 5) & 0b1;
 		break;
 	case 0x0400004B:
 		WINOUT &= 0xFF; WINOUT |= (value << 8);
-		for (int i = 0; i < 4; i++)
-			m_windows[2].layerDrawable[i] = (WINOUT >> (8 + i)) & 0b1;
-		m_windows[2].objDrawable = (WINOUT >> 12) & 0b1;
-		m_windows[2].blendable = (WINOUT >> 13) & 0b1;
 		break;
 	case 0x04000020:
 		BG2PA &= 0xFF00; BG2PA |= value;
@@ -1593,15 +1647,7 @@ void PPU::onSchedulerEvent(void* context)
 	thisPtr->eventHandler();
 }
 
-void PPU::onHBlankIRQEvent(void* context)
-{
-	PPU* thisPtr = (PPU*)context;
-	thisPtr->triggerHBlankIRQ();
-}
-
 int PPU::getVCOUNT()
 {
 	return VCOUNT;
-}
-
-uint32_t PPU::m_safeDisplayBuffer[240 * 160] = {};
\ No newline at end of file
+}
\ No newline at end of file
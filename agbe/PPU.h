@@ -4,8 +4,12 @@
 #include"GBAMem.h"
 #include"InterruptManager.h"
 #include"Scheduler.h"
+#include"Config.h"
 
 #include<array>
+#include<memory>
+#include<thread>
+#include<atomic>
 #include<Windows.h>
 
 struct BG
@@ -26,9 +30,6 @@ struct Window
 	int16_t x2;
 	int16_t y1;
 	int16_t y2;
-	bool layerDrawable[4];
-	bool objDrawable;
-	bool blendable;
 };
 
 union SpriteAttribute
@@ -69,56 +70,186 @@ union OAMEntry
 	};
 };
 
-enum class PPUState
+//oam entry decoded once when oam changes, rather than on every line it's drawn on
+struct SpriteInfo
 {
-	HDraw,
-	HBlank,
-	VBlank,
-	VBlankHBlank
+	int16_t top;
+	int16_t left;
+	int16_t width;
+	int16_t height;			//not including double-size
+	int16_t rowPitch;		//tiles per row with 1d mapping
+	uint16_t charName;
+	uint8_t priority;
+	uint8_t paletteNumber;
+	uint8_t affineParams;	//which group of PA-PD in oam
+	bool affine;
+	bool doubleSize;
+	bool hiColor;
+	bool flipHorizontal;
+	bool flipVertical;
+	bool mosaic;
+	bool semiTransparent;
+	bool objWindow;
+};
+
+enum class OutputFormat
+{
+	RGBA8888,
+	BGRA8888,
+	XRGB8888,
+	RGB565
+};
+
+//private copy of video memory for the render thread, same layout as the end of GBAMem
+struct VideoMemory
+{
+	uint8_t paletteRAM[1024];
+	uint8_t VRAM[96 * 1024];
+	uint8_t OAM[1024];
+};
+
+//finished frames go to the frontend through three buffers: the ppu renders into its back buffer, then swaps it with 'ready' at vblank.
+//the frontend swaps its front buffer with 'ready' whenever there's a newer frame there - so nobody waits, and frames are never copied
+struct DisplayBuffers
+{
+	static constexpr uint8_t freshFrame = 0b100;	//set in 'ready' until the frontend takes that frame
+
+	uint32_t buffers[3][240 * 160] = {};
+	uint64_t sequence[3] = {};						//frame number each buffer holds, written before the buffer's published
+	std::atomic<uint8_t> ready = 1;
+	uint8_t front = 0;								//only touched by the frontend
+	uint64_t framesPublished = 0;					//only touched by the ppu
+};
+
+enum class RenderCommandType : uint8_t
+{
+	IOWrite,
+	PaletteWrite,
+	VRAMWrite,
+	OAMWrite,
+	DrawLine,
+	EndDrawLine,
+	EndVBlankLine,
+	Reset,
+	SetOutputFormat,
+	Stop
+};
+
+struct RenderCommand
+{
+	RenderCommandType type;
+	uint8_t size;
+	uint32_t address;
+	uint32_t value;
+};
+
+//everything a scanline's output depends on. if a line's inputs match what they were last time it was drawn, the old output is reused
+struct ScanlineInputs
+{
+	uint16_t DISPCNT;
+	uint16_t BGCNT[4];
+	uint16_t BGHOFS[4];
+	uint16_t BGVOFS[4];
+	uint16_t BGAffineParams[8];		//BG2PA-PD, BG3PA-PD
+	uint32_t BGAffineLatches[4];	//BG2X/Y, BG3X/Y latches
+	Window windows[2];
+	uint16_t WININ;
+	uint16_t WINOUT;
+	uint16_t BLDCNT;
+	uint16_t BLDALPHA;
+	uint16_t BLDY;
+	uint16_t MOSAIC;
+	int32_t verticalMosaicCounter;
+	uint8_t bgEnabled[4];
+	uint32_t paletteGeneration;
+	uint32_t oamGeneration;
+	uint32_t vramGeneration[6];		//per 16KB block, only the blocks this line's enabled layers can read from
+};
+
+struct ScanlineRecord
+{
+	ScanlineInputs inputs;
+	uint32_t BGAffineLatchesAfter[4];	//rendering a line steps the affine latches, so a reused line has to as well
+	int32_t verticalMosaicCounterAfter;
+	uint8_t page;						//which display buffer the output is in
+	bool valid;
+};
+
+//points within a scanline where the ppu has something to do. the line event walks through these, skipping any with no work
+enum class LinePhase
+{
+	HBlankStart,
+	HBlankIRQ,
+	LineEnd
 };
 
 class PPU
 {
 public:
-	PPU(std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler);
+	PPU(GBAMem& mem, InterruptManager& interruptManager, Scheduler& scheduler);
 	~PPU();
 
 	void reset();
-	void updateDisplayOutput();
-
-	void registerMemory(std::shared_ptr<GBAMem> mem);
+	const void* acquireDisplayFrame(uint64_t* sequence = nullptr);	//frontend side: latest finished frame, never blocks
 
 	uint8_t readIO(uint32_t address);
 	void writeIO(uint32_t address, uint8_t value);
 
 	void registerDMACallbacks(callbackFn HBlank, callbackFn VBlank, callbackFn videoCapture, void*ctx);
 	static void onSchedulerEvent(void* context);
-	static void onHBlankIRQEvent(void* context);
 
 	int getVCOUNT();
+	void setOutputFormat(OutputFormat format);		//set before the emulator starts running - the display buffer is written in this format directly
+
+	//bus calls these after every palette/vram/oam write (address is the offset into that memory)
+	inline void onPaletteWrite(uint32_t address)
+	{
+		if (m_renderWorker)
+			logMemoryWrite(RenderCommandType::PaletteWrite, m_paletteRAM, address & 0x3FE, 2);
+		else
+			updatePaletteCache(address);
+	}
+	inline void onVRAMWrite(uint32_t address, int size)
+	{
+		if (m_renderWorker)
+			logMemoryWrite(RenderCommandType::VRAMWrite, m_VRAM, address, size);
+		else
+			invalidateTile(address);
+	}
+	inline void onOAMWrite(uint32_t address, int size)
+	{
+		if (m_renderWorker)
+			logMemoryWrite(RenderCommandType::OAMWrite, m_OAM, address, size);
+		else
+			m_oamGeneration++;
+	}
 	bool getBitmapMode() { return ((DISPCNT & 0b111)) >= 3; }
-	static uint32_t m_safeDisplayBuffer[240 * 160];
 private:
-	bool registered = false;
-	std::shared_ptr<GBAMem> m_mem;
-	std::shared_ptr<InterruptManager> m_interruptManager;
-	std::shared_ptr<Scheduler> m_scheduler;
-	uint32_t m_renderBuffer[2][240 * 160];	//currently being rendered
-	bool pageIdx = false;
+	PPU(PPU& owner, VideoMemory& mem);		//render thread's copy
+
+	InterruptManager& m_interruptManager;
+	Scheduler& m_scheduler;
+	uint8_t* m_paletteRAM;
+	uint8_t* m_VRAM;
+	uint8_t* m_OAM;
+	std::unique_ptr<DisplayBuffers> m_displayBuffers;	//only the emu thread's ppu has these
+	DisplayBuffers* m_display = nullptr;				//render thread's copy points at the emu thread ppu's buffers
+	uint8_t pageIdx = 2;								//back buffer
+	void publishFrame();
 	uint16_t m_spriteLineBuffer[240] = {};
 	SpriteAttribute m_spriteAttrBuffer[240] = {};
+	uint8_t m_windowMask[240] = {};		//per pixel enable bits for current line, same layout as WININ/WINOUT (bg0-3, obj, blend)
 
 	int m_spriteCyclesElapsed = 0;		//checks how many cycles have elapsed since sprite rendering started, to enforce the max allowed cycles for sprite pre-rendering
 
 	BG m_backgroundLayers[4];
-	Window m_windows[4];
+	Window m_windows[2];
 
-	PPUState m_state = {};
+	static constexpr uint64_t linePhaseOffsets[3] = { 1007, 1011, 1232 };	//cycles from the start of the line
+	LinePhase m_linePhase = LinePhase::HBlankStart;
+	uint64_t m_lineStartTimestamp = 0;
 
-	uint32_t m_lineCycles = 0;
 	bool inVBlank = false;
-	bool vblank_setHblankBit = false;
-	bool hblank_flagSet = false;
 
 	callbackFn DMAHBlankCallback = nullptr;
 	callbackFn DMAVBlankCallback = nullptr;
@@ -126,11 +257,65 @@ private:
 	void* callbackContext = nullptr;
 
 	void eventHandler();
-	void triggerHBlankIRQ();
-
-	void HDraw();
-	void HBlank();
-	void VBlank();
+	void scheduleLinePhase(LinePhase phase);
+	void scheduleLine();
+
+	void onHBlankStart();
+	void onLineEnd();
+	bool getHBlankFlag();
+
+	void renderLine();
+	void drawScanline();
+
+	//generation counters, bumped on writes so scanline inputs can be compared cheaply
+	uint32_t m_paletteGeneration = 0;
+	uint32_t m_oamGeneration = 0;
+	uint32_t m_vramGeneration[6] = {};
+	ScanlineRecord m_scanlineRecords[160] = {};
+	uint32_t m_linesRendered = 0;
+	uint32_t m_linesReused = 0;
+	void captureScanlineInputs(ScanlineInputs& inputs);
+	void invalidateScanlineRecords();
+	void updateLineReuseStats();
+	bool shouldSkipFrame();
+	bool m_skipFrame = false;		//decided at the start of each frame. rendering never feeds back into emulated state, so skipping it is free timing-wise
+	uint32_t m_frameCounter = 0;
+	void advanceDrawLine();
+	void advanceVBlankLine();
+	void resetRenderState();
+
+	//threaded rendering: the emu thread logs everything rendering depends on (ppu io writes, palette/vram/oam writes and line transitions)
+	//in order, and a second ppu on the render thread replays it against its own copy of video memory. output is exactly the same, just off the emu thread
+	static constexpr uint32_t renderQueueSize = 65536;
+	std::unique_ptr<PPU> m_renderWorker;
+	std::unique_ptr<VideoMemory> m_renderWorkerMem;
+	std::unique_ptr<RenderCommand[]> m_renderQueue;
+	std::atomic<uint32_t> m_renderQueueWritePos = 0;		//published by emu thread
+	std::atomic<uint32_t> m_renderQueueReadPos = 0;			//published by render thread
+	uint32_t m_renderQueuePending = 0;						//emu thread's write position, published on line boundaries
+	uint32_t m_renderQueueCachedReadPos = 0;				//emu thread's last look at m_renderQueueReadPos, so it doesn't hit the atomic every push
+	std::thread m_renderThread;
+
+	void startRenderThread();
+	void stopRenderThread();
+	void renderThreadLoop();
+	void pushRenderCommand(RenderCommandType type, uint32_t address = 0, uint32_t value = 0, uint8_t size = 1);
+	void pushLineCommand(RenderCommandType type, uint32_t value = 0);
+	void publishRenderCommands();
+	void logMemoryWrite(RenderCommandType type, const uint8_t* mem, uint32_t address, int size);
+	void applyRenderCommand(const RenderCommand& command);
+
+	inline void updatePaletteCache(uint32_t address)
+	{
+		uint32_t entry = (address & 0x3FF) >> 1;
+		m_paletteCache[entry] = (m_paletteRAM[entry * 2] | (m_paletteRAM[(entry * 2) + 1] << 8)) & 0x7FFF;
+		m_paletteGeneration++;
+	}
+	inline void invalidateTile(uint32_t vramAddress)
+	{
+		m_tileDirty[(vramAddress >> 5) & 0xFFF] = true;
+		m_vramGeneration[min(vramAddress >> 14, 5u)]++;
+	}
 
 	void checkVCOUNTInterrupt();
 	bool vcountIRQLine = false;
@@ -144,23 +329,103 @@ private:
 
 	void composeLayers();
 
+	//composeLayers resolves the top pixel, blend targets and blend mode for each pixel, then one of these blends the whole line
+	//(result goes back into m_composeTop). picked at startup depending on what the cpu supports
+	typedef void(PPU::*blendLineFn)();
+	blendLineFn m_blendLine = nullptr;
+	uint16_t m_composeTop[240] = {};
+	uint16_t m_composeTargetA[240] = {};
+	uint16_t m_composeTargetB[240] = {};
+	alignas(16) uint8_t m_composeBlendMode[240] = {};	//0=none, 1=alpha, 2=brighten, 3=darken. only set if the targets needed are actually there
+
+	void blendLineScalar();
+	void blendLineSSE41();
+	void blendLineAVX2();
+	static blendLineFn selectBlendLine();
+	void writeOutputLine();
+
+	uint16_t m_paletteCache[512] = {};		//palette ram as 15 bit colours, so lookups are one load
+	uint32_t m_outputLUT[32768] = {};		//BGR555 -> output format
+	OutputFormat m_outputFormat = OutputFormat::RGBA8888;
+	int m_bytesPerPixel = 4;
+
 	void drawBackground(int bg);
 	void drawRotationScalingBackground(int bg);
+
+	//non-mosaic affine/bitmap lines (PPU_Affine.cpp): coords for the whole line are generated up front, then fetched in one go
+	alignas(16) int32_t m_affineX[240] = {};
+	alignas(16) int32_t m_affineY[240] = {};
+	alignas(16) uint32_t m_affineAddress[240] = {};
+	alignas(16) uint32_t m_affineTexelOffset[240] = {};
+	alignas(16) int32_t m_affineValid[240] = {};
+	void computeAffineLine(int32_t xRef, int32_t yRef, int16_t pA, int16_t pC);
+	template<int width, int height, int bytesPerPixel> void drawBitmapLine(uint32_t base, int32_t xRef, int32_t yRef, int16_t pA, int16_t pC);
+	template<bool wrap> void drawAffineTileLine(int bg, int screenSize, uint32_t mapBase, uint32_t tileBase, int32_t xRef, int32_t yRef, int16_t pA, int16_t pC);
 	void drawSprites(bool bitmapMode=false);
-	void drawAffineSprite(OAMEntry* curSpriteEntry);
+	void drawAffineSprite(const SpriteInfo& sprite);
+
+	//sprites bucketed by the lines they cover (in oam order), rebuilt when oam's been written to
+	SpriteInfo m_spriteInfo[128] = {};
+	int16_t m_spriteAffineParams[32][4] = {};
+	uint8_t m_spriteLines[160][128] = {};
+	uint8_t m_spriteLineCount[160] = {};
+	uint32_t m_spriteListGeneration = 0xFFFFFFFF;
+	void buildSpriteLists();
+	inline void plotSpritePixel(const SpriteInfo& sprite, int plotCoord, uint16_t col)
+	{
+		bool currentPixelTransparent = col >> 15;
+		if (sprite.objWindow)
+		{
+			if (!currentPixelTransparent)
+				m_spriteAttrBuffer[plotCoord].objWindow = 1;
+			return;
+		}
+
+		uint8_t priorityAtPixel = m_spriteAttrBuffer[plotCoord].priority;
+		bool renderedPixelTransparent = m_spriteLineBuffer[plotCoord] >> 15;
+		if ((sprite.priority >= priorityAtPixel) && (!renderedPixelTransparent || currentPixelTransparent))	//keep rendering if lower priority, BUT last pixel transparent
+			return;
+
+		m_spriteAttrBuffer[plotCoord].priority = sprite.priority & 0b11111;
+		m_spriteAttrBuffer[plotCoord].transparent = sprite.semiTransparent;
+		m_spriteAttrBuffer[plotCoord].mosaic = sprite.mosaic;
+		if (!currentPixelTransparent)
+			m_spriteLineBuffer[plotCoord] = col;
+	}
 
 	uint16_t extractColorFromTile(uint32_t tileBase, uint32_t xOffset, bool hiColor, bool sprite, uint32_t palette);
 
+	//4bpp tiles unpacked to one palette index per byte, decoded lazily when a tile's been written to.
+	//8bpp tiles are already laid out like that in vram, so they're read straight from there
+	static constexpr int numTiles4bpp = (96 * 1024) / 32;
+	uint8_t m_decodedTiles[numTiles4bpp][64];
+	bool m_tileDirty[numTiles4bpp + 1024];		//padded so invalidateTile can mask instead of range checking
+	uint8_t m_scratchTileRow[8];
+	void decodeTileRow(const uint8_t* src, uint8_t* dst);
+	inline const uint8_t* getTileRow4bpp(uint32_t rowAddress)		//rowAddress = vram address of the 4 byte row
+	{
+		uint32_t tileIdx = rowAddress >> 5;
+		if (tileIdx >= numTiles4bpp) [[unlikely]]		//garbage tile numbers can point past vram, so just decode whatever's there
+		{
+			decodeTileRow(&m_VRAM[rowAddress], m_scratchTileRow);
+			return m_scratchTileRow;
+		}
+		if (m_tileDirty[tileIdx])
+		{
+			for (int row = 0; row < 8; row++)
+				decodeTileRow(&m_VRAM[(tileIdx * 32) + (row * 4)], &m_decodedTiles[tileIdx][row * 8]);
+			m_tileDirty[tileIdx] = false;
+		}
+		return &m_decodedTiles[tileIdx][(rowAddress & 0x1F) * 2];
+	}
+
 	uint16_t blendBrightness(uint16_t col, bool increase);
 	uint16_t blendAlpha(uint16_t colA, uint16_t colB);
 
 	void setVBlankFlag(bool value);
-	void setHBlankFlag(bool value);
 	void setVCounterFlag(bool value);
 
-	uint32_t col16to32(uint16_t col);
-
-	Window getWindowAttributes(int x, int y);
+	void buildWindowMask();
 
 	void latchBackgroundEnableBits();
 
@@ -0,0 +1,108 @@
+#include"PPU.h"
+
+#include<immintrin.h>
+
+//non-mosaic fast paths for affine + bitmap backgrounds. without mosaic the reference point just steps by PA/PC every pixel, so the
+//whole line's coordinates/addresses can be worked out with (sse2) vector math up front, leaving a tight fetch loop with no branches.
+//must give identical results to the per-pixel loops (which are still used when mosaic is on)
+
+void PPU::computeAffineLine(int32_t xRef, int32_t yRef, int16_t pA, int16_t pC)
+{
+	//unsigned arithmetic so wrapping matches stepping one pixel at a time
+	uint32_t x = (uint32_t)xRef, y = (uint32_t)yRef;
+	__m128i xCoords = _mm_setr_epi32(x, x + pA, x + (pA * 2), x + (pA * 3));
+	__m128i yCoords = _mm_setr_epi32(y, y + pC, y + (pC * 2), y + (pC * 3));
+	const __m128i xStep = _mm_set1_epi32(pA * 4);
+	const __m128i yStep = _mm_set1_epi32(pC * 4);
+	for (int i = 0; i < 240; i += 4)
+	{
+		_mm_store_si128((__m128i*)&m_affineX[i], _mm_srai_epi32(xCoords, 8));
+		_mm_store_si128((__m128i*)&m_affineY[i], _mm_srai_epi32(yCoords, 8));
+		xCoords = _mm_add_epi32(xCoords, xStep);
+		yCoords = _mm_add_epi32(yCoords, yStep);
+	}
+}
+
+template<int width, int height, int bytesPerPixel>
+void PPU::drawBitmapLine(uint32_t base, int32_t xRef, int32_t yRef, int16_t pA, int16_t pC)
+{
+	computeAffineLine(xRef, yRef, pA, pC);
+
+	const __m128i coordMask = _mm_set1_epi32(0xFFFFF);
+	const __m128i maxX = _mm_set1_epi32(width);
+	const __m128i maxY = _mm_set1_epi32(height);
+	const __m128i rowBytes = _mm_set1_epi32(width * bytesPerPixel);
+	for (int i = 0; i < 240; i += 4)
+	{
+		__m128i x = _mm_and_si128(_mm_load_si128((const __m128i*)&m_affineX[i]), coordMask);
+		__m128i y = _mm_and_si128(_mm_load_si128((const __m128i*)&m_affineY[i]), coordMask);
+		__m128i valid = _mm_and_si128(_mm_cmplt_epi32(x, maxX), _mm_cmplt_epi32(y, maxY));
+
+		//y*rowBytes with madd: upper halves of rowBytes are 0, and y's low half is exact whenever the pixel's valid
+		__m128i address = _mm_madd_epi16(y, rowBytes);
+		address = _mm_add_epi32(address, (bytesPerPixel == 2) ? _mm_slli_epi32(x, 1) : x);
+		_mm_store_si128((__m128i*)&m_affineAddress[i], _mm_and_si128(address, valid));	//invalid pixels read address 0, then get thrown away
+		_mm_store_si128((__m128i*)&m_affineValid[i], valid);
+	}
+
+	uint16_t* lineBuffer = m_backgroundLayers[2].lineBuffer;
+	for (int i = 0; i < 240; i++)
+	{
+		uint32_t address = base + m_affineAddress[i];
+		uint16_t col = 0;
+		if constexpr (bytesPerPixel == 2)
+			col = (m_VRAM[address] | (m_VRAM[address + 1] << 8)) & 0x7FFF;
+		else
+			col = m_paletteCache[m_VRAM[address]];
+		lineBuffer[i] = (m_affineValid[i]) ? col : 0x8000;
+	}
+}
+
+template void PPU::drawBitmapLine<240, 160, 2>(uint32_t, int32_t, int32_t, int16_t, int16_t);	//mode 3
+template void PPU::drawBitmapLine<240, 160, 1>(uint32_t, int32_t, int32_t, int16_t, int16_t);	//mode 4
+template void PPU::drawBitmapLine<160, 128, 2>(uint32_t, int32_t, int32_t, int16_t, int16_t);	//mode 5
+
+template<bool wrap>
+void PPU::drawAffineTileLine(int bg, int screenSize, uint32_t mapBase, uint32_t tileBase, int32_t xRef, int32_t yRef, int16_t pA, int16_t pC)
+{
+	computeAffineLine(xRef, yRef, pA, pC);
+
+	uint32_t size = 128 << screenSize;
+	const __m128i mapRowShift = _mm_cvtsi32_si128(4 + screenSize);		//each map row is size/8 entries
+	const __m128i sizeMask = _mm_set1_epi32(size - 1);
+	const __m128i maxCoord = _mm_set1_epi32(size);
+	const __m128i minusOne = _mm_set1_epi32(-1);
+	const __m128i seven = _mm_set1_epi32(7);
+	const __m128i mapBaseVec = _mm_set1_epi32(mapBase);
+	for (int i = 0; i < 240; i += 4)
+	{
+		__m128i x = _mm_load_si128((const __m128i*)&m_affineX[i]);
+		__m128i y = _mm_load_si128((const __m128i*)&m_affineY[i]);
+		__m128i valid = minusOne;
+		if constexpr (!wrap)		//coords are compared as unsigned, so negative ones are out of range too
+		{
+			valid = _mm_and_si128(_mm_cmpgt_epi32(x, minusOne), _mm_cmplt_epi32(x, maxCoord));
+			valid = _mm_and_si128(valid, _mm_and_si128(_mm_cmpgt_epi32(y, minusOne), _mm_cmplt_epi32(y, maxCoord)));
+		}
+		x = _mm_and_si128(x, sizeMask);
+		y = _mm_and_si128(y, sizeMask);
+
+		__m128i mapAddress = _mm_add_epi32(mapBaseVec, _mm_add_epi32(_mm_sll_epi32(_mm_srli_epi32(y, 3), mapRowShift), _mm_srli_epi32(x, 3)));
+		__m128i texelOffset = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(y, seven), 3), _mm_and_si128(x, seven));
+		_mm_store_si128((__m128i*)&m_affineAddress[i], _mm_and_si128(mapAddress, valid));
+		_mm_store_si128((__m128i*)&m_affineTexelOffset[i], texelOffset);
+		_mm_store_si128((__m128i*)&m_affineValid[i], valid);
+	}
+
+	uint16_t* lineBuffer = m_backgroundLayers[bg].lineBuffer;
+	for (int i = 0; i < 240; i++)
+	{
+		uint32_t tileIdx = m_VRAM[m_affineAddress[i]];
+		uint8_t colorIdx = m_VRAM[tileBase + (tileIdx * 64) + m_affineTexelOffset[i]];
+		uint16_t col = (colorIdx) ? m_paletteCache[colorIdx] : 0x8000;
+		lineBuffer[i] = (m_affineValid[i]) ? col : 0x8000;
+	}
+}
+
+template void PPU::drawAffineTileLine<true>(int, int, uint32_t, uint32_t, int32_t, int32_t, int16_t, int16_t);
+template void PPU::drawAffineTileLine<false>(int, int, uint32_t, uint32_t, int32_t, int32_t, int16_t, int16_t);
@@ -0,0 +1,163 @@
+#include"PPU.h"
+
+#include<intrin.h>
+#include<immintrin.h>
+
+//blending for a whole line. composeLayers has already picked the top pixel, both blend targets and the blend mode
+//for every pixel, so all that's left here is straight arithmetic - which vectorises nicely. every version must give identical results to blendAlpha/blendBrightness!
+//the blended line is left in m_composeTop as BGR555, writeOutputLine then converts it to whatever format the display wants
+
+PPU::blendLineFn PPU::selectBlendLine()
+{
+	int cpuInfo[4] = {};
+	__cpuid(cpuInfo, 0);
+	int maxLeaf = cpuInfo[0];
+
+	__cpuid(cpuInfo, 1);
+	bool sse41 = ((cpuInfo[2] >> 19) & 0b1);
+	bool osxsave = ((cpuInfo[2] >> 27) & 0b1);
+	bool avx = ((cpuInfo[2] >> 28) & 0b1);
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && avx && ((_xgetbv(0) & 0b110) == 0b110))	//os has to save ymm regs too
+	{
+		__cpuidex(cpuInfo, 7, 0);
+		avx2 = ((cpuInfo[1] >> 5) & 0b1);
+	}
+
+	if (avx2)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Info, "Using AVX2 line compositor");
+		return &PPU::blendLineAVX2;
+	}
+	if (sse41)
+	{
+		Logger::getInstance()->msg(LoggerSeverity::Info, "Using SSE4.1 line compositor");
+		return &PPU::blendLineSSE41;
+	}
+	Logger::getInstance()->msg(LoggerSeverity::Info, "Using scalar line compositor");
+	return &PPU::blendLineScalar;
+}
+
+void PPU::blendLineScalar()
+{
+	for (int x = 0; x < 240; x++)
+	{
+		uint16_t finalCol = m_composeTop[x];
+		switch (m_composeBlendMode[x])
+		{
+		case 1:
+			finalCol = blendAlpha(m_composeTargetA[x], m_composeTargetB[x]);
+			break;
+		case 2:
+			finalCol = blendBrightness(m_composeTargetA[x], true);
+			break;
+		case 3:
+			finalCol = blendBrightness(m_composeTargetA[x], false);
+			break;
+		}
+		m_composeTop[x] = finalCol;
+	}
+}
+
+void PPU::blendLineSSE41()
+{
+	const __m128i channelMask = _mm_set1_epi16(0x1F);
+	const __m128i maxChannel = _mm_set1_epi16(31);
+	const __m128i coeffA = _mm_set1_epi16(min(16, BLDALPHA & 0x1F));
+	const __m128i coeffB = _mm_set1_epi16(min(16, (BLDALPHA >> 8) & 0x1F));
+	const __m128i coeffY = _mm_set1_epi16(min(16, BLDY & 0x1F));
+	const __m128i mode1 = _mm_set1_epi16(1), mode2 = _mm_set1_epi16(2), mode3 = _mm_set1_epi16(3);
+
+	for (int x = 0; x < 240; x += 8)
+	{
+		__m128i top = _mm_loadu_si128((const __m128i*)&m_composeTop[x]);
+		__m128i colA = _mm_loadu_si128((const __m128i*)&m_composeTargetA[x]);
+		__m128i colB = _mm_loadu_si128((const __m128i*)&m_composeTargetB[x]);
+		__m128i mode = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i*)&m_composeBlendMode[x]));
+
+		__m128i channelsA[3], channelsB[3];
+		for (int c = 0; c < 3; c++)
+		{
+			channelsA[c] = _mm_and_si128(_mm_srli_epi16(colA, c * 5), channelMask);
+			channelsB[c] = _mm_and_si128(_mm_srli_epi16(colB, c * 5), channelMask);
+		}
+
+		__m128i alpha = _mm_setzero_si128(), brighten = _mm_setzero_si128(), darken = _mm_setzero_si128();
+		for (int c = 0; c < 3; c++)
+		{
+			__m128i a = channelsA[c];
+			__m128i alphaChannel = _mm_min_epu16(maxChannel, _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(a, coeffA), 4), _mm_srli_epi16(_mm_mullo_epi16(channelsB[c], coeffB), 4)));
+			__m128i brightenChannel = _mm_add_epi16(a, _mm_srli_epi16(_mm_mullo_epi16(_mm_sub_epi16(maxChannel, a), coeffY), 4));
+			__m128i darkenChannel = _mm_sub_epi16(a, _mm_srli_epi16(_mm_mullo_epi16(a, coeffY), 4));
+			alpha = _mm_or_si128(alpha, _mm_slli_epi16(alphaChannel, c * 5));
+			brighten = _mm_or_si128(brighten, _mm_slli_epi16(brightenChannel, c * 5));
+			darken = _mm_or_si128(darken, _mm_slli_epi16(darkenChannel, c * 5));
+		}
+
+		__m128i col = top;
+		col = _mm_blendv_epi8(col, alpha, _mm_cmpeq_epi16(mode, mode1));
+		col = _mm_blendv_epi8(col, brighten, _mm_cmpeq_epi16(mode, mode2));
+		col = _mm_blendv_epi8(col, darken, _mm_cmpeq_epi16(mode, mode3));
+		_mm_storeu_si128((__m128i*)&m_composeTop[x], col);
+	}
+}
+
+void PPU::blendLineAVX2()
+{
+	const __m256i channelMask = _mm256_set1_epi16(0x1F);
+	const __m256i maxChannel = _mm256_set1_epi16(31);
+	const __m256i coeffA = _mm256_set1_epi16(min(16, BLDALPHA & 0x1F));
+	const __m256i coeffB = _mm256_set1_epi16(min(16, (BLDALPHA >> 8) & 0x1F));
+	const __m256i coeffY = _mm256_set1_epi16(min(16, BLDY & 0x1F));
+	const __m256i mode1 = _mm256_set1_epi16(1), mode2 = _mm256_set1_epi16(2), mode3 = _mm256_set1_epi16(3);
+
+	for (int x = 0; x < 240; x += 16)
+	{
+		__m256i top = _mm256_loadu_si256((const __m256i*)&m_composeTop[x]);
+		__m256i colA = _mm256_loadu_si256((const __m256i*)&m_composeTargetA[x]);
+		__m256i colB = _mm256_loadu_si256((const __m256i*)&m_composeTargetB[x]);
+		__m256i mode = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)&m_composeBlendMode[x]));
+
+		__m256i channelsA[3], channelsB[3];
+		for (int c = 0; c < 3; c++)
+		{
+			channelsA[c] = _mm256_and_si256(_mm256_srli_epi16(colA, c * 5), channelMask);
+			channelsB[c] = _mm256_and_si256(_mm256_srli_epi16(colB, c * 5), channelMask);
+		}
+
+		__m256i alpha = _mm256_setzero_si256(), brighten = _mm256_setzero_si256(), darken = _mm256_setzero_si256();
+		for (int c = 0; c < 3; c++)
+		{
+			__m256i a = channelsA[c];
+			__m256i alphaChannel = _mm256_min_epu16(maxChannel, _mm256_add_epi16(_mm256_srli_epi16(_mm256_mullo_epi16(a, coeffA), 4), _mm256_srli_epi16(_mm256_mullo_epi16(channelsB[c], coeffB), 4)));
+			__m256i brightenChannel = _mm256_add_epi16(a, _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(maxChannel, a), coeffY), 4));
+			__m256i darkenChannel = _mm256_sub_epi16(a, _mm256_srli_epi16(_mm256_mullo_epi16(a, coeffY), 4));
+			alpha = _mm256_or_si256(alpha, _mm256_slli_epi16(alphaChannel, c * 5));
+			brighten = _mm256_or_si256(brighten, _mm256_slli_epi16(brightenChannel, c * 5));
+			darken = _mm256_or_si256(darken, _mm256_slli_epi16(darkenChannel, c * 5));
+		}
+
+		__m256i col = top;
+		col = _mm256_blendv_epi8(col, alpha, _mm256_cmpeq_epi16(mode, mode1));
+		col = _mm256_blendv_epi8(col, brighten, _mm256_cmpeq_epi16(mode, mode2));
+		col = _mm256_blendv_epi8(col, darken, _mm256_cmpeq_epi16(mode, mode3));
+		_mm256_storeu_si256((__m256i*)&m_composeTop[x], col);
+	}
+}
+
+void PPU::writeOutputLine()
+{
+	uint8_t* out = (uint8_t*)m_display->buffers[pageIdx] + (240 * VCOUNT * m_bytesPerPixel);
+	if (m_outputFormat == OutputFormat::RGB565)
+	{
+		uint16_t* out16 = (uint16_t*)out;
+		for (int x = 0; x < 240; x++)
+			out16[x] = (uint16_t)m_outputLUT[m_composeTop[x]];
+		return;
+	}
+
+	uint32_t* out32 = (uint32_t*)out;
+	for (int x = 0; x < 240; x++)
+		out32[x] = m_outputLUT[m_composeTop[x]];
+}
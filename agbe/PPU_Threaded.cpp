@@ -0,0 +1,143 @@
+#include"PPU.h"
+
+//threaded renderer. the emu thread's ppu still does all the timing (irqs, dma triggers, dispstat/vcount), but instead of rendering it
+//logs every io write, palette/vram/oam write and line transition. the worker ppu replays that log in order with its own copy of
+//video memory, so it sees exactly the state the emu thread would have rendered from
+
+PPU::PPU(PPU& owner, VideoMemory& mem) : m_interruptManager(owner.m_interruptManager), m_scheduler(owner.m_scheduler),
+	m_paletteRAM(mem.paletteRAM), m_VRAM(mem.VRAM), m_OAM(mem.OAM), m_display(owner.m_display), pageIdx(owner.pageIdx)
+{
+	//never touches the scheduler or interrupts - only the rendering side runs here
+	m_blendLine = owner.m_blendLine;
+	memset(m_tileDirty, 1, sizeof(m_tileDirty));
+	setOutputFormat(owner.m_outputFormat);
+	for (uint32_t i = 0; i < 512; i++)
+		updatePaletteCache(i * 2);
+
+	for (int i = 0; i < 4; i++)
+		m_backgroundLayers[i] = {};
+	m_windows[0] = {};
+	m_windows[1] = {};
+	resetRenderState();
+}
+
+void PPU::startRenderThread()
+{
+	m_renderWorkerMem = std::make_unique<VideoMemory>();
+	memcpy(m_renderWorkerMem->paletteRAM, m_paletteRAM, sizeof(VideoMemory::paletteRAM));
+	memcpy(m_renderWorkerMem->VRAM, m_VRAM, sizeof(VideoMemory::VRAM));
+	memcpy(m_renderWorkerMem->OAM, m_OAM, sizeof(VideoMemory::OAM));
+
+	m_renderWorker = std::unique_ptr<PPU>(new PPU(*this, *m_renderWorkerMem));
+	m_renderQueue = std::make_unique<RenderCommand[]>(renderQueueSize);
+	m_renderThread = std::thread(&PPU::renderThreadLoop, this);
+	Logger::getInstance()->msg(LoggerSeverity::Info, "Using threaded renderer");
+}
+
+void PPU::stopRenderThread()
+{
+	if (!m_renderThread.joinable())
+		return;
+	pushLineCommand(RenderCommandType::Stop);
+	m_renderThread.join();
+}
+
+void PPU::renderThreadLoop()
+{
+	uint32_t readPos = 0;
+	while (true)
+	{
+		uint32_t writePos = m_renderQueueWritePos.load(std::memory_order_acquire);
+		if (readPos == writePos)
+		{
+			m_renderQueueWritePos.wait(writePos, std::memory_order_acquire);
+			continue;
+		}
+
+		for (; readPos != writePos; readPos++)
+		{
+			const RenderCommand& command = m_renderQueue[readPos & (renderQueueSize - 1)];
+			if (command.type == RenderCommandType::Stop)
+				return;
+			m_renderWorker->applyRenderCommand(command);
+			m_renderQueueReadPos.store(readPos + 1, std::memory_order_release);
+		}
+	}
+}
+
+void PPU::pushRenderCommand(RenderCommandType type, uint32_t address, uint32_t value, uint8_t size)
+{
+	if ((m_renderQueuePending - m_renderQueueCachedReadPos) == renderQueueSize)
+	{
+		m_renderQueueCachedReadPos = m_renderQueueReadPos.load(std::memory_order_acquire);
+		if ((m_renderQueuePending - m_renderQueueCachedReadPos) == renderQueueSize) [[unlikely]]	//really full, so wait for the render thread to catch up
+		{
+			publishRenderCommands();
+			while ((m_renderQueuePending - m_renderQueueReadPos.load(std::memory_order_acquire)) == renderQueueSize)
+				std::this_thread::yield();
+			m_renderQueueCachedReadPos = m_renderQueueReadPos.load(std::memory_order_acquire);
+		}
+	}
+
+	m_renderQueue[m_renderQueuePending & (renderQueueSize - 1)] = { type, size, address, value };
+	m_renderQueuePending++;
+}
+
+void PPU::pushLineCommand(RenderCommandType type, uint32_t value)
+{
+	pushRenderCommand(type, 0, value);
+	publishRenderCommands();
+}
+
+void PPU::publishRenderCommands()
+{
+	m_renderQueueWritePos.store(m_renderQueuePending, std::memory_order_release);
+	m_renderQueueWritePos.notify_one();
+}
+
+void PPU::logMemoryWrite(RenderCommandType type, const uint8_t* mem, uint32_t address, int size)
+{
+	uint32_t value = 0;
+	memcpy(&value, &mem[address], size);		//log what actually ended up in memory, so the bus's write quirks carry over
+	pushRenderCommand(type, address, value, size);
+}
+
+void PPU::applyRenderCommand(const RenderCommand& command)
+{
+	switch (command.type)
+	{
+	case RenderCommandType::IOWrite:
+		writeIO(command.address, command.value);
+		break;
+	case RenderCommandType::PaletteWrite:
+		memcpy(&m_paletteRAM[command.address], &command.value, command.size);
+		updatePaletteCache(command.address);
+		break;
+	case RenderCommandType::VRAMWrite:
+		memcpy(&m_VRAM[command.address], &command.value, command.size);
+		invalidateTile(command.address);
+		break;
+	case RenderCommandType::OAMWrite:
+		memcpy(&m_OAM[command.address], &command.value, command.size);
+		m_oamGeneration++;
+		break;
+	case RenderCommandType::DrawLine:
+		renderLine();
+		break;
+	case RenderCommandType::EndDrawLine:
+		m_skipFrame = command.value;
+		advanceDrawLine();		//publishes the frame at the end of it
+		break;
+	case RenderCommandType::EndVBlankLine:
+		advanceVBlankLine();
+		break;
+	case RenderCommandType::Reset:
+		resetRenderState();
+		break;
+	case RenderCommandType::SetOutputFormat:
+		setOutputFormat((OutputFormat)command.value);
+		break;
+	case RenderCommandType::Stop:		//handled by the render loop before it gets here
+		break;
+	}
+}
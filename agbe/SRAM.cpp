@@ -3,17 +3,18 @@
 SRAM::SRAM(BackupType type)
 {
 	std::vector<uint8_t> saveData;
+	memset((void*)mem, 0xFF, 32768);
 	if (getSaveData(saveData))
 	{
-		memcpy(mem, (void*)&saveData[0], 32768);
+		memcpy(mem, saveData.data(), (std::min)(saveData.size(), (size_t)32768));
 	}
-	else
-		memset((void*)mem, 0xFF, 32768);
+
+	startSaveFlush(32768, saveData.size() >= 32768);	//rewrite whole file if it's missing or truncated
 }
 
 SRAM::~SRAM()
 {
-	writeSaveData((void*)mem, 32768);
+	stopSaveFlush();
 }
 
 uint8_t SRAM::read(uint32_t address)
@@ -24,4 +25,10 @@ uint8_t SRAM::read(uint32_t address)
 void SRAM::write(uint32_t address, uint8_t value)
 {
 	mem[address & 0x7FFF] = value;
+	markDirty(address & 0x7FFF);
+}
+
+void SRAM::readSaveBytes(uint32_t offset, uint8_t* out, int size)
+{
+	memcpy(out, mem + offset, size);
 }
\ No newline at end of file
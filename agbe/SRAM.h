@@ -3,7 +3,7 @@
 #include"Logger.h"
 #include"BackupBase.h"
 
-class SRAM : public BackupBase
+class SRAM final : public BackupBase
 {
 public:
 	SRAM(BackupType type);
@@ -13,4 +13,6 @@ public:
 	void write(uint32_t address, uint8_t value);
 private:
 	uint8_t mem[32768];
+
+	void readSaveBytes(uint32_t offset, uint8_t* out, int size);
 };
\ No newline at end of file
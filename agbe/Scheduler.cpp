@@ -43,7 +43,6 @@ void Scheduler::jumpToNextEvent()
 	m_entries.pop_front();				
 	timestamp = lowestEntry.timestamp;
 	eventTime = timestamp;
-	m_lastFiredEvent = lowestEntry.eventType;
 	lowestEntry.callback(lowestEntry.context);
 }
 
@@ -103,7 +102,6 @@ bool Scheduler::getEntryAtTimestamp(SchedulerEntry& entry)
 	std::list<SchedulerEntry>::iterator it = m_entries.begin();
 	if ((*it).timestamp <= timestamp)
 	{
-		m_lastFiredEvent = (*it).eventType;
 		entry = *it;
 		m_entries.pop_front();
 		return true;
@@ -117,8 +115,3 @@ void Scheduler::invalidateAll()
 	eventTime = 0;
 	m_entries.clear();
 }
-
-Event Scheduler::getLastFiredEvent()
-{
-	return m_lastFiredEvent;
-}
\ No newline at end of file
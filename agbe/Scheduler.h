@@ -19,9 +19,7 @@ enum class Event
 	Frame=7,
 	AudioSample=8,
 	FrameSequencer=9,
-	IRQ=10,
-	HBlankIRQ=11,
-	TimerRegWrite=12
+	IRQ=10
 };
 
 struct SchedulerEntry
@@ -52,8 +50,6 @@ public:
 	void removeEvent(Event type);
 
 	void invalidateAll();
-
-	Event getLastFiredEvent();
 private:
 	bool getEntryAtTimestamp(SchedulerEntry& entry);
 	uint64_t timestamp;
@@ -61,6 +57,4 @@ private:
 	uint64_t syncDelta = 0;
 	bool shouldSync = false;
 	std::list<SchedulerEntry> m_entries;
-
-	Event m_lastFiredEvent = Event::Frame;
 };
\ No newline at end of file
@@ -1,9 +1,8 @@
 #include"SerialStub.h"
 
-SerialStub::SerialStub(std::shared_ptr<Scheduler> scheduler, std::shared_ptr<InterruptManager> interruptManager)
+SerialStub::SerialStub(Scheduler& scheduler, InterruptManager& interruptManager) : m_scheduler(scheduler), m_interruptManager(interruptManager)
 {
-	m_scheduler = scheduler;
-	m_interruptManager = interruptManager;
+
 }
 
 SerialStub::~SerialStub()
@@ -78,7 +77,7 @@ void SerialStub::serialEvent()
 
 	bool doIrq = ((SIOCNT >> 14) & 0b1);
 	if (doIrq)
-		m_interruptManager->requestInterrupt(InterruptType::Serial);
+		m_interruptManager.requestInterrupt(InterruptType::Serial);
 	SIOCNT &= 01101000001111111;
 }
 
@@ -95,9 +94,9 @@ void SerialStub::calculateNextEvent()
 	uint64_t cycleLUT[2] = { 64,8 };	//0: 64 clocks per transfer. 1: 8 clocks per transfer
 	uint64_t transferLength = (wordTransfer) ? 32 : 8;
 
-	uint64_t transferClocks = (transferLength * cycleLUT[shiftClock]) + m_scheduler->getCurrentTimestamp();
-	m_scheduler->removeEvent(Event::Serial);	
-	m_scheduler->addEvent(Event::Serial, &SerialStub::eventCallback, (void*)this, transferClocks);
+	uint64_t transferClocks = (transferLength * cycleLUT[shiftClock]) + m_scheduler.getCurrentTimestamp();
+	m_scheduler.removeEvent(Event::Serial);	
+	m_scheduler.addEvent(Event::Serial, &SerialStub::eventCallback, (void*)this, transferClocks);
 }
 
 void SerialStub::eventCallback(void* context)
@@ -11,7 +11,7 @@
 class SerialStub
 {
 public:
-	SerialStub(std::shared_ptr<Scheduler> scheduler, std::shared_ptr<InterruptManager> interruptManager);
+	SerialStub(Scheduler& scheduler, InterruptManager& interruptManager);
 	~SerialStub();
 
 	uint8_t readIO(uint32_t address);
@@ -19,8 +19,8 @@ public:
 
 	static void eventCallback(void* context);
 private:
-	std::shared_ptr<Scheduler> m_scheduler;
-	std::shared_ptr<InterruptManager> m_interruptManager;
+	Scheduler& m_scheduler;
+	InterruptManager& m_interruptManager;
 
 	void serialEvent();
 	void calculateNextEvent();
@@ -1,9 +1,7 @@
 #include"Timer.h"
 
-Timer::Timer(std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler)
+Timer::Timer(InterruptManager& interruptManager, Scheduler& scheduler) : m_interruptManager(interruptManager), m_scheduler(scheduler)
 {
-	m_scheduler = scheduler;
-	m_interruptManager = interruptManager;
 	for (int i = 0; i < 4; i++)	//clear timer io registers
 		m_timers[i] = {};
 }
@@ -20,39 +18,21 @@ void Timer::registerAPUCallbacks(callbackFn timer0, callbackFn timer1, void* ctx
 	apuCtx = ctx;
 }
 
-void Timer::event()
+void Timer::event(int timerIdx)
 {
-	uint64_t currentTimestamp = m_scheduler->getEventTime();
-
-	int timerIdx = 0;
-	switch (m_scheduler->getLastFiredEvent())
-	{
-	case Event::TIMER0:
-		break;
-	case Event::TIMER1:
-		timerIdx = 1;
-		break;
-	case Event::TIMER2:
-		timerIdx = 2;
-		break;
-	case Event::TIMER3:
-		timerIdx = 3;
-		break;
-	}
-
 	uint8_t ctrlreg = m_timers[timerIdx].CNT_H;
 	bool timerEnabled = (ctrlreg >> 7) & 0b1;
 	bool cascade = (ctrlreg >> 2) & 0b1;
 	uint64_t timerOverflowTime = m_timers[timerIdx].overflowTime;
 	//overflowed, need to handle
-	m_timers[timerIdx].initialClock = m_timers[timerIdx].CNT_L;
+	m_timers[timerIdx].initialClock = getReload(timerIdx, timerOverflowTime);
 	m_timers[timerIdx].clock = m_timers[timerIdx].initialClock;
 	calculateNextOverflow(timerIdx, timerOverflowTime);	//don't update with our current clock, because we might have overshot the overflow time slightly.
-	setCurrentClock(timerIdx, m_timers[timerIdx].CNT_H & 0b11, m_scheduler->getCurrentTimestamp());
-	checkCascade(timerIdx + 1);
+	setCurrentClock(timerIdx, m_timers[timerIdx].CNT_H & 0b11, m_scheduler.getCurrentTimestamp());
+	checkCascade(timerIdx + 1, timerOverflowTime);
 	bool doIrq = (ctrlreg >> 6) & 0b1;
 	if (doIrq)
-		m_interruptManager->requestInterrupt(irqLUT[timerIdx]);
+		m_interruptManager.requestInterrupt(irqLUT[timerIdx]);
 
 	if ((timerIdx == 0 || timerIdx == 1) && timerEnabled && !cascade)
 		apuOverflowCallbacks[timerIdx](apuCtx);
@@ -63,18 +43,16 @@ uint8_t Timer::readIO(uint32_t address)
 	uint32_t timerIdx = ((address - 0x4000100) / 4);	//4000100-4000103 = timer 0, etc.
 	uint32_t addrOffset = ((address - 0x4000100) & 3);	//figure out which byte we're writing (0-3)
 
-	setCurrentClock(timerIdx, m_timers[timerIdx].CNT_H & 0b11,m_scheduler->getCurrentTimestamp());
-
-	bool cascade = (m_timers[timerIdx].CNT_H >> 2) & 0b1;
-	if (cascade)
-		m_scheduler->tick();	//hehe - the aging cart cascade test requires quite tight timing, so force all pending events to fire first 
-								//some pending timer events may occur too late otherwise, which means we fail :(
+	//worked out from the timestamp, so overflows (incl. cascades) that the scheduler hasn't got round to yet are already accounted for.
+	//the aging cart cascade test needs this to be tight
+	uint64_t overflows = 0;
+	uint16_t counter = getCounter(timerIdx, m_scheduler.getCurrentTimestamp(), overflows);
 	switch (addrOffset)
 	{
 	case 0:
-		return m_timers[timerIdx].clock & 0xFF;
+		return counter & 0xFF;
 	case 1:
-		return (m_timers[timerIdx].clock >> 8) & 0xFF;
+		return (counter >> 8) & 0xFF;
 	case 2:
 		return m_timers[timerIdx].CNT_H & 0xFF;
 	case 3:
@@ -87,26 +65,29 @@ void Timer::writeIO(uint32_t address, uint8_t value)
 	uint32_t timerIdx = ((address - 0x4000100) / 4);	//4000100-4000103 = timer 0, etc.
 	uint32_t addrOffset = ((address - 0x4000100) & 3);	//figure out which byte we're writing (0-3)
 
+	//writes take effect a cycle later. rather than scheduling that, reload writes are resolved by timestamp whenever the reload is used,
+	//and control writes are applied straight away as of the cycle they land
+	TimerRegister& timer = m_timers[timerIdx];
+	uint64_t writeTime = m_scheduler.getCurrentTimestamp() + 1;
 	switch (addrOffset)
 	{
 	case 0:
-		//m_timers[timerIdx].CNT_L &= 0xFF00; m_timers[timerIdx].CNT_L |= value;
-		m_timers[timerIdx].newReloadVal &= 0xFF00; m_timers[timerIdx].newReloadVal |= value;
-		m_timers[timerIdx].newReloadWritten = true;
-		m_scheduler->addEvent(Event::TimerRegWrite, &Timer::onReloadRegWrite, (void*)this, m_scheduler->getCurrentTimestamp() + 1);
+		if (timer.newReloadWritten && writeTime > timer.reloadWriteTime)	//previous write has landed
+			timer.CNT_L = timer.newReloadVal;
+		timer.newReloadVal &= 0xFF00; timer.newReloadVal |= value;
+		timer.newReloadWritten = true;
+		timer.reloadWriteTime = writeTime;
 		break;
 	case 1:
-		m_timers[timerIdx].newReloadVal &= 0xFF;  m_timers[timerIdx].newReloadVal |= (value << 8);
-		if (!m_timers[timerIdx].newReloadWritten)	//if for some reason only the top byte of the reload is written? 
-		{
-			m_timers[timerIdx].newReloadWritten = true;
-			m_scheduler->addEvent(Event::TimerRegWrite, &Timer::onReloadRegWrite, (void*)this, m_scheduler->getCurrentTimestamp() + 1);
-		}
+		if (timer.newReloadWritten && writeTime > timer.reloadWriteTime)
+			timer.CNT_L = timer.newReloadVal;
+		timer.newReloadVal &= 0xFF;  timer.newReloadVal |= (value << 8);
+		timer.newReloadWritten = true;
+		timer.reloadWriteTime = writeTime;
 		break;
 	case 2:
-		m_timers[timerIdx].newControlWritten = true;
-		m_timers[timerIdx].newControlVal = value;
-		m_scheduler->addEvent(Event::TimerRegWrite, &Timer::onControlRegWrite, (void*)this, m_scheduler->getCurrentTimestamp() + 1);
+		catchUpOverflows(timerIdx, writeTime);		//overflows due before the write lands still happen with the old settings
+		writeControl(timerIdx, value, writeTime);
 		break;
 	}
 }
@@ -129,8 +110,8 @@ void Timer::calculateNextOverflow(int timerIdx, uint64_t timeBase)
 	uint64_t currentTime = timeBase;
 	uint64_t overflowTimestamp = currentTime + cyclesToOverflow;
 
-	m_scheduler->removeEvent(timerEventLUT[timerIdx]);	//just in case :)
-	m_scheduler->addEvent(timerEventLUT[timerIdx], &Timer::onSchedulerEvent, (void*)this, overflowTimestamp);
+	m_scheduler.removeEvent(timerEventLUT[timerIdx]);	//just in case :)
+	m_scheduler.addEvent(timerEventLUT[timerIdx], overflowCallbackLUT[timerIdx], (void*)this, overflowTimestamp);
 
 	m_timers[timerIdx].timeActivated = currentTime;
 	m_timers[timerIdx].lastUpdateClock = (currentTime >> shiftLut[prescalerSelect]);
@@ -138,7 +119,7 @@ void Timer::calculateNextOverflow(int timerIdx, uint64_t timeBase)
 
 }
 
-void Timer::checkCascade(int timerIdx)
+void Timer::checkCascade(int timerIdx, uint64_t timestamp)
 {
 	if (timerIdx > 3)
 		return;
@@ -150,11 +131,11 @@ void Timer::checkCascade(int timerIdx)
 
 	if (m_timers[timerIdx].clock == 0xFFFF)
 	{
-		m_timers[timerIdx].clock = m_timers[timerIdx].CNT_L;
+		m_timers[timerIdx].clock = getReload(timerIdx, timestamp);
 		bool doIrq = (timerctrl >> 6) & 0b1;
 		if (doIrq)
-			m_interruptManager->requestInterrupt(irqLUT[timerIdx]);
-		checkCascade(timerIdx + 1);
+			m_interruptManager.requestInterrupt(irqLUT[timerIdx]);
+		checkCascade(timerIdx + 1, timestamp);
 	}
 	else
 		m_timers[timerIdx].clock++;
@@ -177,71 +158,130 @@ void Timer::setCurrentClock(int idx, uint8_t prescalerSetting, uint64_t timestam
 	m_timers[idx].lastUpdateClock = currentClock;
 }
 
-void Timer::writeControl()
+uint16_t Timer::getCounter(int idx, uint64_t timestamp, uint64_t& overflows)
 {
-	for (int timerIdx = 0; timerIdx < 4; timerIdx++)
+	//closed form: ticks since the clock was last brought up to date, wrapped around the reload value. 'overflows' is how many times
+	//it's wrapped in that time, which is what a cascaded timer above counts
+	overflows = 0;
+	bool timerEnabled = ((m_timers[idx].CNT_H >> 7) & 0b1);
+	bool countup = ((m_timers[idx].CNT_H >> 2) & 0b1);
+	if (!timerEnabled && !countup)		//checkCascade counts cascaded timers regardless of enable, so this has to as well
+		return m_timers[idx].clock;
+
+	static constexpr uint64_t shiftLut[4] = { 0,6,8,10 };
+	uint64_t ticks = 0;
+	if (countup)
+		getCounter(idx - 1, timestamp, ticks);
+	else
 	{
-		if (!m_timers[timerIdx].newControlWritten)
-			continue;
-		m_timers[timerIdx].newControlWritten = false;
-		setCurrentClock(timerIdx, m_timers[timerIdx].CNT_H & 0b11,m_scheduler->getEventTime());				//update clock first if possible
-		bool timerWasEnabled = (m_timers[timerIdx].CNT_H >> 7) & 0b1;
-		bool timerNowEnabled = (m_timers[timerIdx].newControlVal >> 7) & 0b1;
-		bool countup = ((m_timers[timerIdx].newControlVal >> 2) & 0b1);
-		bool wasCountup = (m_timers[timerIdx].CNT_H >> 2) & 0b1;
-		uint8_t oldPrescalerSetting = m_timers[timerIdx].CNT_H & 0b11;
-		uint8_t newPrescalerSetting = m_timers[timerIdx].newControlVal & 0b11;
-
-		m_timers[timerIdx].CNT_H = m_timers[timerIdx].newControlVal;
-
-		if (timerIdx == 0)
-		{
-			m_timers[timerIdx].CNT_H &= 0b11111011;	//clear cascade bit on timer0
-			countup = false;
-		}
+		uint64_t currentClock = (timestamp >> shiftLut[m_timers[idx].CNT_H & 0b11]);
+		if (currentClock > m_timers[idx].lastUpdateClock)		//can be behind for a cycle after the timer starts
+			ticks = currentClock - m_timers[idx].lastUpdateClock;
+	}
+
+	uint64_t count = m_timers[idx].clock + ticks;
+	if (count <= 0xFFFF)
+		return count;
+
+	//the first wrap uses whatever the reload was when it happened - a reload write could land between then and now
+	uint64_t firstOverflowTime = countup ? timestamp : m_timers[idx].overflowTime;
+	count = getReload(idx, firstOverflowTime) + (count - 0x10000);
+	overflows = 1;
+	if (count <= 0xFFFF)
+		return count;
+	uint16_t reload = getReload(idx, timestamp);
+	uint64_t period = 0x10000 - reload;
+	count -= 0x10000;
+	overflows += 1 + (count / period);
+	return reload + (count % period);
+}
 
-		if (!timerWasEnabled && timerNowEnabled)
+uint16_t Timer::getReload(int idx, uint64_t timestamp)
+{
+	if (m_timers[idx].newReloadWritten && timestamp >= m_timers[idx].reloadWriteTime)
+		return m_timers[idx].newReloadVal;
+	return m_timers[idx].CNT_L;
+}
+
+void Timer::catchUpOverflows(int timerIdx, uint64_t timestamp)
+{
+	//fire overflows the scheduler hasn't got to yet, oldest first. timers below this one count too, they can cascade into it
+	while (true)
+	{
+		int nextIdx = -1;
+		for (int i = 0; i <= timerIdx; i++)
 		{
-			m_timers[timerIdx].clock = m_timers[timerIdx].CNT_L;	//load in reload value
-			if (!countup)
-			{
-				m_timers[timerIdx].initialClock = m_timers[timerIdx].clock;
-				calculateNextOverflow(timerIdx, m_scheduler->getEventTime()+1);		//+1 to account for 2-cycle startup delay
-			}
+			if (getCountingIndependently(i) && m_timers[i].overflowTime <= timestamp && (nextIdx < 0 || m_timers[i].overflowTime < m_timers[nextIdx].overflowTime))
+				nextIdx = i;
 		}
-		if (timerWasEnabled && timerNowEnabled)
-			calculateNextOverflow(timerIdx, m_scheduler->getEventTime());
-
-		if ((timerWasEnabled && !timerNowEnabled) || (countup))			//if timer becomes disabled, or it becomes a countup timer: unschedule
-			m_scheduler->removeEvent(timerEventLUT[timerIdx]);
+		if (nextIdx < 0)
+			return;
+		event(nextIdx);
 	}
 }
 
-void Timer::writeReload()
+bool Timer::getCountingIndependently(int idx)
+{
+	//enabled and counting cycles, i.e. has an overflow event scheduled
+	return ((m_timers[idx].CNT_H >> 7) & 0b1) && !((m_timers[idx].CNT_H >> 2) & 0b1);
+}
+
+void Timer::writeControl(int timerIdx, uint8_t value, uint64_t timestamp)
 {
-	for (int timerIdx = 0; timerIdx < 4; timerIdx++)
+	setCurrentClock(timerIdx, m_timers[timerIdx].CNT_H & 0b11, timestamp);				//update clock first if possible
+	bool timerWasEnabled = (m_timers[timerIdx].CNT_H >> 7) & 0b1;
+	bool timerNowEnabled = (value >> 7) & 0b1;
+	bool countup = ((value >> 2) & 0b1);
+	bool wasCountup = (m_timers[timerIdx].CNT_H >> 2) & 0b1;
+	uint8_t oldPrescalerSetting = m_timers[timerIdx].CNT_H & 0b11;
+	uint8_t newPrescalerSetting = value & 0b11;
+
+	m_timers[timerIdx].CNT_H = value;
+
+	if (timerIdx == 0)
+	{
+		m_timers[timerIdx].CNT_H &= 0b11111011;	//clear cascade bit on timer0
+		countup = false;
+	}
+
+	if (!timerWasEnabled && timerNowEnabled)
 	{
-		if (!m_timers[timerIdx].newReloadWritten)
-			continue;
-		m_timers[timerIdx].newReloadWritten = false;
-		m_timers[timerIdx].CNT_L=m_timers[timerIdx].newReloadVal;
+		m_timers[timerIdx].clock = getReload(timerIdx, timestamp);	//load in reload value
+		if (!countup)
+		{
+			m_timers[timerIdx].initialClock = m_timers[timerIdx].clock;
+			calculateNextOverflow(timerIdx, timestamp+1);		//+1 to account for 2-cycle startup delay
+		}
 	}
+	if (timerWasEnabled && timerNowEnabled)
+		calculateNextOverflow(timerIdx, timestamp);
+
+	if ((timerWasEnabled && !timerNowEnabled) || (countup))			//if timer becomes disabled, or it becomes a countup timer: unschedule
+		m_scheduler.removeEvent(timerEventLUT[timerIdx]);
+}
+
+const callbackFn Timer::overflowCallbackLUT[4] = { &Timer::timer0Callback, &Timer::timer1Callback, &Timer::timer2Callback, &Timer::timer3Callback };
+
+void Timer::timer0Callback(void* context)
+{
+	Timer* thisPtr = (Timer*)context;
+	thisPtr->event(0);
 }
 
-void Timer::onSchedulerEvent(void* context)
+void Timer::timer1Callback(void* context)
 {
 	Timer* thisPtr = (Timer*)context;
-	thisPtr->event();
+	thisPtr->event(1);
 }
 
-void Timer::onControlRegWrite(void* context)
+void Timer::timer2Callback(void* context)
 {
 	Timer* thisPtr = (Timer*)context;
-	thisPtr->writeControl();
+	thisPtr->event(2);
 }
 
-void Timer::onReloadRegWrite(void* context)
+void Timer::timer3Callback(void* context)
 {
 	Timer* thisPtr = (Timer*)context;
-	thisPtr->writeReload();
+	thisPtr->event(3);
 }
\ No newline at end of file
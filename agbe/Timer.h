@@ -14,42 +14,45 @@ struct TimerRegister
 	uint64_t overflowTime;
 	uint64_t lastUpdateClock;
 
-	uint16_t newControlVal;
-	bool newControlWritten = false;
-
 	uint16_t newReloadVal;
 	bool newReloadWritten = false;
+	uint64_t reloadWriteTime;		//reload writes land a cycle later, CNT_L holds the old value until then
 };
 
 class Timer
 {
 public:
-	Timer(std::shared_ptr<InterruptManager> interruptManager, std::shared_ptr<Scheduler> scheduler);
+	Timer(InterruptManager& interruptManager, Scheduler& scheduler);
 	void registerAPUCallbacks(callbackFn timer0, callbackFn timer1, void* ctx);
 	~Timer();
 
 	uint8_t readIO(uint32_t address);
 	void writeIO(uint32_t address, uint8_t value);
 
-	static void onSchedulerEvent(void* context);
-	static void onControlRegWrite(void* context);
-	static void onReloadRegWrite(void* context);
+	static void timer0Callback(void* context);
+	static void timer1Callback(void* context);
+	static void timer2Callback(void* context);
+	static void timer3Callback(void* context);
 
 private:
 	static constexpr Event timerEventLUT[4] = { Event::TIMER0,Event::TIMER1,Event::TIMER2,Event::TIMER3 };
 	static constexpr InterruptType irqLUT[4] = { InterruptType::Timer0,InterruptType::Timer1,InterruptType::Timer2,InterruptType::Timer3 };
-	void event();
+	static const callbackFn overflowCallbackLUT[4];
+	void event(int timerIdx);
 	void calculateNextOverflow(int timerIdx, uint64_t timeBase);
-	void checkCascade(int timerIdx);
+	void checkCascade(int timerIdx, uint64_t timestamp);
 	void setCurrentClock(int idx, uint8_t prescalerSetting, uint64_t timestamp);
+	uint16_t getCounter(int idx, uint64_t timestamp, uint64_t& overflows);
+	uint16_t getReload(int idx, uint64_t timestamp);
+	bool getCountingIndependently(int idx);
+	void catchUpOverflows(int timerIdx, uint64_t timestamp);
 
-	void writeControl();
-	void writeReload();
+	void writeControl(int timerIdx, uint8_t value, uint64_t timestamp);
 	TimerRegister m_timers[4];
 
 	callbackFn apuOverflowCallbacks[2];
 	void* apuCtx;
 
-	std::shared_ptr<InterruptManager> m_interruptManager;
-	std::shared_ptr<Scheduler> m_scheduler;
+	InterruptManager& m_interruptManager;
+	Scheduler& m_scheduler;
 };
\ No newline at end of file
@@ -10,7 +10,7 @@
 void emuWorkerThread();
 void dragDropCallback(GLFWwindow* window, int count, const char** paths);
 std::shared_ptr<GBA> m_gba;
-std::shared_ptr<InputState> inputState;
+std::shared_ptr<SharedInputState> inputState;
 
 FILE* coutStream, *cinStream;
 
@@ -45,49 +45,57 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
 	Display m_display(4);
 	m_display.registerDragDropCallback((GLFWdropfun)dragDropCallback);
 
-	inputState = std::make_shared<InputState>();
+	inputState = std::make_shared<SharedInputState>();
 	std::thread m_workerThread;
+	uint64_t lastFrameSequence = UINT64_MAX;
 	Config::GBA.shouldReset = true;
 	while (!m_display.getShouldClose())
 	{
 		if (Config::GBA.shouldReset)
 		{
+			inputState->wakeWaiters();		//in case the instance is sitting in STOP
 			if (m_workerThread.joinable())
 				m_workerThread.join();
 			m_gba = nullptr;
 			if (Config::GBA.RomName.length())
 			{
 				m_gba = std::make_shared<GBA>();
+				lastFrameSequence = UINT64_MAX;
 				m_gba->registerInput(inputState);
 				m_workerThread = std::thread(&emuWorkerThread);
 			}
 		}
 		else
 		{
-			//update texture
-			void* data = m_gba->getPPUData();
-			if (data != nullptr)
+			//update texture, only if the emu thread's finished another frame since
+			uint64_t frameSequence = 0;
+			const void* data = m_gba->getPPUData(&frameSequence);
+			if (data != nullptr && frameSequence != lastFrameSequence)
 				m_display.update(data);
+			lastFrameSequence = frameSequence;
 		}
 		m_display.draw();
 
-		//blarg. key input
-		inputState->A = m_display.getPressed(GLFW_KEY_X);
-		inputState->B = m_display.getPressed(GLFW_KEY_Z);
-		inputState->L = m_display.getPressed(GLFW_KEY_A);
-		inputState->R = m_display.getPressed(GLFW_KEY_S);
-		inputState->Start = m_display.getPressed(GLFW_KEY_ENTER);
-		inputState->Select = m_display.getPressed(GLFW_KEY_RIGHT_SHIFT);
-		inputState->Up = m_display.getPressed(GLFW_KEY_UP);
-		inputState->Down = m_display.getPressed(GLFW_KEY_DOWN);
-		inputState->Left = m_display.getPressed(GLFW_KEY_LEFT);
-		inputState->Right = m_display.getPressed(GLFW_KEY_RIGHT);
+		//blarg. key input - built up locally then published in one go, so the emu thread never sees half an update
+		InputState keys = {};
+		keys.A = m_display.getPressed(GLFW_KEY_X);
+		keys.B = m_display.getPressed(GLFW_KEY_Z);
+		keys.L = m_display.getPressed(GLFW_KEY_A);
+		keys.R = m_display.getPressed(GLFW_KEY_S);
+		keys.Start = m_display.getPressed(GLFW_KEY_ENTER);
+		keys.Select = m_display.getPressed(GLFW_KEY_RIGHT_SHIFT);
+		keys.Up = m_display.getPressed(GLFW_KEY_UP);
+		keys.Down = m_display.getPressed(GLFW_KEY_DOWN);
+		keys.Left = m_display.getPressed(GLFW_KEY_LEFT);
+		keys.Right = m_display.getPressed(GLFW_KEY_RIGHT);
+		inputState->update(keys);
 
 	}
 
 	if (m_workerThread.joinable())
 	{
 		Config::GBA.shouldReset = true;
+		inputState->wakeWaiters();
 		m_workerThread.join();
 	}
 	m_gba = nullptr;